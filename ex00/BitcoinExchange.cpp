@@ -4,12 +4,17 @@
 // Ctors & Dtors & Copy Assignment Operators
 // =============================================================================
 
-BitcoinExchange::BitcoinExchange() {}
+BitcoinExchange::BitcoinExchange():
+	_shardOverlapCount(0)
+{}
 
 BitcoinExchange::~BitcoinExchange() {}
 
 BitcoinExchange::BitcoinExchange(const BitcoinExchange &other):
-	_database(other._database)
+	_database(other._database),
+	_shardOverlapCount(other._shardOverlapCount),
+	_rateTables(other._rateTables),
+	_joinedRates(other._joinedRates)
 {}
 
 BitcoinExchange	&BitcoinExchange::operator=(const BitcoinExchange &other)
@@ -17,6 +22,9 @@ BitcoinExchange	&BitcoinExchange::operator=(const BitcoinExchange &other)
 	if (this != &other)
 	{
 		this->_database = other._database;
+		this->_shardOverlapCount = other._shardOverlapCount;
+		this->_rateTables = other._rateTables;
+		this->_joinedRates = other._joinedRates;
 	}
 	return (*this);
 }
@@ -25,6 +33,29 @@ BitcoinExchange	&BitcoinExchange::operator=(const BitcoinExchange &other)
 // CSV File
 // =============================================================================
 bool	BitcoinExchange::loadCSVFile(const std::string &filepath)
+{
+	std::map<std::string, double>	run;
+	if (parseCSVShard(filepath, run) == false)
+		return (false);
+	std::map<std::string, double>::const_iterator it = run.begin();
+	while (it != run.end())
+	{
+		_database[it->first] = it->second;
+		++it;
+	}
+	if (_database.empty())
+		return (false);
+	else
+		return (true);
+}
+
+/*
+	Parse one CSV file into its own sorted run.
+	Same rules as the single file loader: last line wins for a repeated date.
+	Only touches `run`, so several shards can be parsed at the same time.
+*/
+bool	BitcoinExchange::parseCSVShard(const std::string &filepath,
+										std::map<std::string, double> &run) const
 {
 	std::ifstream	file(filepath.c_str());
 	if (!file)
@@ -40,7 +71,7 @@ bool	BitcoinExchange::loadCSVFile(const std::string &filepath)
 			std::string	date;
 			double	price;
 			if (parseCSVLine(line, date, price))
-				_database[date] = price;
+				run[date] = price;
 		}
 	}
 
@@ -51,15 +82,12 @@ bool	BitcoinExchange::loadCSVFile(const std::string &filepath)
 		std::string	date;
 		double	price;
 		if (parseCSVLine(line, date, price))
-			_database[date] = price;
+			run[date] = price;
 	}
-	if (_database.empty())
-		return (false);
-	else
-		return (true);
+	return (true);
 }
 
-bool	BitcoinExchange::parseCSVLine(std::string &line, std::string &date, double &price)
+bool	BitcoinExchange::parseCSVLine(std::string &line, std::string &date, double &price) const
 {
 	// Expected: YYYY-MM-DD,price
 	std::string::size_type	comma = line.find(',');
@@ -79,7 +107,7 @@ bool	BitcoinExchange::parseCSVLine(std::string &line, std::string &date, double
 	return (true);
 }
 
-bool	BitcoinExchange::parsePrice(std::string &price_str, double &price)
+bool	BitcoinExchange::parsePrice(std::string &price_str, double &price) const
 {
 	char	*end = 0;
 	errno = 0;
@@ -94,6 +122,345 @@ bool	BitcoinExchange::parsePrice(std::string &price_str, double &price)
 	return (true);
 }
 
+// =============================================================================
+// Sharded CSV Files
+// =============================================================================
+
+void	*BitcoinExchange::parseShardRoutine(void *arg)
+{
+	CSVShard	*shard = static_cast<CSVShard *>(arg);
+	shard->opened = shard->owner->parseCSVShard(shard->path, shard->run);
+	return (0);
+}
+
+/*
+	Load several CSV shards (e.g. data_2011.csv, data_2012.csv, ...).
+	- each shard is parsed on its own thread into a sorted run
+	- the runs are then merged in one pass (see mergeShardRuns)
+	- shards are ranked by their position in `filepaths`: a later shard wins
+	  on a repeated date, exactly like loading them one after the other
+
+	If a thread cannot be created, that shard is parsed on the calling thread.
+	Returns false if any shard cannot be opened or nothing was loaded.
+*/
+bool	BitcoinExchange::loadCSVShards(const std::vector<std::string> &filepaths)
+{
+	if (filepaths.empty())
+		return (false);
+	std::vector<CSVShard>	shards(filepaths.size());
+	std::vector<pthread_t>	threads(filepaths.size());
+	std::vector<bool>		started(filepaths.size(), false);
+
+	for (size_t i = 0; i < filepaths.size(); i++)
+	{
+		shards[i].owner = this;
+		shards[i].path = filepaths[i];
+		shards[i].opened = false;
+	}
+	for (size_t i = 0; i < shards.size(); i++)
+	{
+		if (pthread_create(&threads[i], 0, &parseShardRoutine, &shards[i]) == 0)
+			started[i] = true;
+		else
+			parseShardRoutine(&shards[i]);
+	}
+	for (size_t i = 0; i < shards.size(); i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], 0);
+	}
+	for (size_t i = 0; i < shards.size(); i++)
+	{
+		if (shards[i].opened == false)
+			return (false);
+	}
+	mergeShardRuns(shards);
+	if (_database.empty())
+		return (false);
+	else
+		return (true);
+}
+
+/*
+	Load every "*.csv" file of a directory as a shard.
+	Files are taken in name order, so per-year files (2011.csv, 2012.csv...)
+	keep their natural order for the last-wins rule.
+*/
+bool	BitcoinExchange::loadCSVDirectory(const std::string &dirpath)
+{
+	DIR	*dir = opendir(dirpath.c_str());
+	if (dir == 0)
+		return (false);
+	std::vector<std::string>	filepaths;
+	struct dirent	*entry;
+	while ((entry = readdir(dir)) != 0)
+	{
+		std::string	name(entry->d_name);
+		if (name.size() > 4 && name.compare(name.size() - 4, 4, ".csv") == 0)
+			filepaths.push_back(dirpath + "/" + name);
+	}
+	closedir(dir);
+	std::sort(filepaths.begin(), filepaths.end());
+	return (loadCSVShards(filepaths));
+}
+
+/*
+	K-way merge of the sorted runs into the database.
+
+	The current database is the oldest run, then the shards in order.
+	At each step take the smallest date among the run heads:
+	- one run has it  -> copy it
+	- several have it -> overlap: the highest ranked run wins (last-wins)
+	Output comes out sorted, so every insert goes at end() in O(1).
+
+	Runs:   A { 01-01, 01-05 }   B { 01-05, 01-09 }
+	Merged: 01-01(A) 01-05(B, overlap) 01-09(B)
+*/
+void	BitcoinExchange::mergeShardRuns(std::vector<CSVShard> &shards)
+{
+	typedef std::map<std::string, double>::const_iterator	RunIt;
+
+	std::map<std::string, double>	previous;
+	previous.swap(_database);
+	std::vector<RunIt>	heads;
+	std::vector<RunIt>	ends;
+	heads.push_back(previous.begin());
+	ends.push_back(previous.end());
+	for (size_t i = 0; i < shards.size(); i++)
+	{
+		heads.push_back(shards[i].run.begin());
+		ends.push_back(shards[i].run.end());
+	}
+
+	_shardOverlapCount = 0;
+	while (true)
+	{
+		const std::string	*smallest = 0;
+		for (size_t i = 0; i < heads.size(); i++)
+		{
+			if (heads[i] != ends[i] && (smallest == 0 || heads[i]->first < *smallest))
+				smallest = &heads[i]->first;
+		}
+		if (smallest == 0)
+			break;
+		std::string	date = *smallest;
+		double		price = 0.0;
+		size_t		found = 0;
+		for (size_t i = 0; i < heads.size(); i++)
+		{
+			if (heads[i] != ends[i] && heads[i]->first == date)
+			{
+				price = heads[i]->second; // later runs overwrite earlier ones
+				++heads[i];
+				found++;
+			}
+		}
+		if (found > 1)
+			_shardOverlapCount++;
+		_database.insert(_database.end(), std::make_pair(date, price));
+	}
+}
+
+size_t	BitcoinExchange::getShardOverlapCount() const
+{
+	return (_shardOverlapCount);
+}
+
+// =============================================================================
+// Cross-Currency Rate Tables
+// =============================================================================
+
+/*
+	Load a rate table "FROM/TO" (same CSV format as data.csv: date,rate).
+	e.g. loadRateTable("USD", "EUR", "usd_eur.csv")
+	A rate <= 0 is skipped like a malformed line: the table may be read
+	inverted (1 / rate) by a conversion path.
+	Joined series are dropped: they must be rebuilt with the new table.
+*/
+bool	BitcoinExchange::loadRateTable(const std::string &from, const std::string &to,
+										const std::string &filepath)
+{
+	std::map<std::string, double>	table;
+	if (parseCSVShard(filepath, table) == false)
+		return (false);
+	std::map<std::string, double>::iterator	it = table.begin();
+	while (it != table.end())
+	{
+		if (it->second <= 0.0)
+			table.erase(it++);
+		else
+			++it;
+	}
+	if (table.empty())
+		return (false);
+	_rateTables[from + "/" + to].swap(table);
+	_joinedRates.clear();
+	return (true);
+}
+
+/*
+	Shortest path (BFS) from BTC to `target` over the rate tables.
+	- the database is the edge BTC -> USD
+	- a table "A/B" is the edge A -> B, and B -> A when inverted (1 / rate),
+	  BTC included: a BTC/EUR table is one hop, BTC -> USD -> EUR two
+
+	BTC --(data.csv)--> USD --(USD/EUR)--> EUR --(JPY/EUR, inverted)--> JPY
+*/
+bool	BitcoinExchange::findConversionPath(const std::string &target,
+											std::vector<RateHop> &hops) const
+{
+	typedef std::map<std::string, std::map<std::string, double> >::const_iterator	TableIt;
+
+	std::map<std::string, RateHop>		cameBy;  // currency -> hop used to reach it
+	std::map<std::string, std::string>	cameFrom;
+	std::queue<std::string>				toVisit;
+
+	cameFrom[BASE_CURRENCY] = "";
+	toVisit.push(BASE_CURRENCY);
+	while (!toVisit.empty() && cameFrom.find(target) == cameFrom.end())
+	{
+		std::string	current = toVisit.front();
+		toVisit.pop();
+		if (current == BASE_CURRENCY && cameFrom.find(QUOTE_CURRENCY) == cameFrom.end())
+		{
+			RateHop	hop;
+			hop.table = &_database;
+			hop.inverted = false;
+			cameBy[QUOTE_CURRENCY] = hop;
+			cameFrom[QUOTE_CURRENCY] = BASE_CURRENCY;
+			toVisit.push(QUOTE_CURRENCY);
+		}
+		for (TableIt it = _rateTables.begin(); it != _rateTables.end(); ++it)
+		{
+			std::string::size_type	slash = it->first.find('/');
+			std::string	from = it->first.substr(0, slash);
+			std::string	to = it->first.substr(slash + 1);
+			RateHop	hop;
+			hop.table = &it->second;
+			std::string	next;
+			if (from == current)
+			{
+				hop.inverted = false;
+				next = to;
+			}
+			else if (to == current)
+			{
+				hop.inverted = true;
+				next = from;
+			}
+			else
+				continue;
+			if (cameFrom.find(next) != cameFrom.end())
+				continue;
+			cameBy[next] = hop;
+			cameFrom[next] = current;
+			toVisit.push(next);
+		}
+	}
+	if (cameFrom.find(target) == cameFrom.end() || target == BASE_CURRENCY)
+		return (false);
+	hops.clear();
+	std::string	current = target;
+	while (current != BASE_CURRENCY)
+	{
+		hops.insert(hops.begin(), cameBy[current]);
+		current = cameFrom[current];
+	}
+	return (true);
+}
+
+/*
+	Materialise the on-or-before product of every hop into one series.
+
+	The product only changes on a date present in one of the tables, so walk
+	the union of all dates in order (k-way, like mergeShardRuns), keeping the
+	latest rate seen for each hop. A date is emitted once every hop has a rate.
+
+	BTC/USD { 01-01: 10, 01-05: 20 }   USD/EUR { 01-03: 0.5 }
+	BTC/EUR { 01-03: 5, 01-05: 10 }
+*/
+void	BitcoinExchange::joinRateSeries(const std::vector<RateHop> &hops,
+										std::map<std::string, double> &joined) const
+{
+	typedef std::map<std::string, double>::const_iterator	RunIt;
+
+	std::vector<RunIt>	heads;
+	std::vector<double>	current(hops.size(), 0.0);
+	std::vector<bool>	seen(hops.size(), false);
+	for (size_t i = 0; i < hops.size(); i++)
+		heads.push_back(hops[i].table->begin());
+
+	joined.clear();
+	while (true)
+	{
+		const std::string	*smallest = 0;
+		for (size_t i = 0; i < hops.size(); i++)
+		{
+			if (heads[i] != hops[i].table->end()
+				&& (smallest == 0 || heads[i]->first < *smallest))
+				smallest = &heads[i]->first;
+		}
+		if (smallest == 0)
+			break;
+		std::string	date = *smallest;
+		for (size_t i = 0; i < hops.size(); i++)
+		{
+			if (heads[i] != hops[i].table->end() && heads[i]->first == date)
+			{
+				double	rate = heads[i]->second;
+				if (hops[i].inverted == false)
+					current[i] = rate;
+				else
+					current[i] = 1.0 / rate; // > 0, checked by loadRateTable
+				seen[i] = true;
+				++heads[i];
+			}
+		}
+		double	product = 1.0;
+		bool	complete = true;
+		for (size_t i = 0; i < hops.size() && complete; i++)
+		{
+			complete = seen[i];
+			product *= current[i];
+		}
+		if (complete)
+			joined.insert(joined.end(), std::make_pair(date, product));
+	}
+}
+
+/*
+	Precompute the BTC -> target series, so a query is one lookup
+	whatever the number of hops.
+*/
+bool	BitcoinExchange::buildConversionPath(const std::string &target)
+{
+	std::vector<RateHop>	hops;
+	if (findConversionPath(target, hops) == false)
+		return (false);
+	std::map<std::string, double>	joined;
+	joinRateSeries(hops, joined);
+	if (joined.empty())
+		return (false);
+	_joinedRates[target].swap(joined);
+	return (true);
+}
+
+bool	BitcoinExchange::findConvertedRateOnOrBefore(const std::string &target,
+													const std::string &date,
+													double &rate) const
+{
+	std::map<std::string, std::map<std::string, double> >::const_iterator	series;
+	series = _joinedRates.find(target);
+	if (series == _joinedRates.end() || series->second.empty())
+		return (false);
+	std::map<std::string, double>::const_iterator it = series->second.upper_bound(date);
+	if (it == series->second.begin()) // every date is after the query
+		return (false);
+	--it;
+	rate = it->second;
+	return (true);
+}
+
 // =============================================================================
 // File Parser
 // =============================================================================
@@ -102,7 +469,7 @@ bool	BitcoinExchange::parsePrice(std::string &price_str, double &price)
 	Accept int or float text
 	Subject requires 0..1000 range checks elsewhere
 */
-bool	BitcoinExchange::parseValue(const std::string &valueStr, double &value)
+bool	BitcoinExchange::parseValue(const std::string &valueStr, double &value) const
 {
 	char	*end = 0;
 	errno = 0;
@@ -167,31 +534,31 @@ bool	BitcoinExchange::findRateOnOrBefore(const std::string &date, double &rate)
 	return (true);
 }
 
-bool	BitcoinExchange::checkAndFetchRate(const std::string &rawLine,
-											const std::string &date,
-											const std::string &valueStr,
-											double &value,
-											double &rate)
+/*
+	One line of the input file, checked up to the rate lookup:
+	"2011-01-03 | 3" -> date "2011-01-03", valueStr "3", value 3.0
+	Every output (BTC/USD, converted targets) reports errors through here.
+*/
+bool	BitcoinExchange::parseInputLine(const std::string &line,
+										std::string &date,
+										std::string &valueStr,
+										double &value)
 {
-	if (isValidDate(date) == false)
-	{
-		std::cerr << "Error: bad input => " << rawLine << std::endl;
-		return (false);
-	}
-	if (parseValue(valueStr, value) == false)
+	// Parse "data | value"
+	std::string::size_type	bar = line.find('|');
+	if (bar == std::string::npos)
 	{
-		std::cerr << "Error: bad input => " << rawLine << std::endl;
+		std::cerr << "Error: bad input => " << line << std::endl;
 		return (false);
 	}
-	if (checkValue(value) == false)
-		return (false);
-	// exchange rate on / before the date
-	if (findRateOnOrBefore(date, rate) == false)
+	date = trim(line.substr(0, bar));
+	valueStr = trim(line.substr(bar + 1));
+	if (isValidDate(date) == false || parseValue(valueStr, value) == false)
 	{
-		std::cerr << "Error: bad input => " << rawLine << std::endl;
+		std::cerr << "Error: bad input => " << line << std::endl;
 		return (false);
 	}
-	return (true);
+	return (checkValue(value));
 }
 
 /*
@@ -217,7 +584,7 @@ bool	BitcoinExchange::checkAndFetchRate(const std::string &rawLine,
 		With fixed or scientific set: precision = digits after the decimal point (e.g., 123.456 → 123.46). ---- I choose thissss since I set to "fixed"
 		With default floatfield (neither fixed nor scientific): precision = significant digits (e.g., 123.456 → 1.2e+02 or 123 depending on magnitude/implementation).
 */
-std::string	BitcoinExchange::formater(double x)
+std::string	BitcoinExchange::formater(double x) const
 {
 	std::ostringstream	oss;
 	oss.setf(std::ios::fixed);
@@ -244,13 +611,13 @@ std::string	BitcoinExchange::formater(double x)
 		With fixed, precision = number of digits after the decimal (so 2 → xx.yy).
 		Without fixed (default floatfield), precision = total significant digits.
 */
-void	BitcoinExchange::loadInputFile(const std::string &filepath)
+bool	BitcoinExchange::openInputFile(const std::string &filepath, std::ifstream &file)
 {
-	std::ifstream	file(filepath.c_str());
+	file.open(filepath.c_str());
 	if (!file)
 	{
 		std::cerr << "Error: could not open file." << std::endl;
-		return ;
+		return (false);
 	}
 	std::string	line;
 
@@ -260,31 +627,74 @@ void	BitcoinExchange::loadInputFile(const std::string &filepath)
 		if (isInputFileHeader(line) == false)
 			file.seekg(0); // reset the cursor
 	}
+	return (true);
+}
 
+void	BitcoinExchange::loadInputFile(const std::string &filepath)
+{
+	std::ifstream	file;
+	if (openInputFile(filepath, file) == false)
+		return ;
+
+	std::string	line;
+	std::string	date;
+	std::string	valueStr;
 	while (std::getline(file, line))
 	{
 		if (line.empty())
 			continue ;
-		
-		// Parse "data | value"
-		std::string::size_type	bar = line.find('|');
-		if (bar == std::string::npos)
+
+		double	value = 0.0;
+		double	rate = 0.0;
+		if (parseInputLine(line, date, valueStr, value) == false)
+			continue;
+		// exchange rate on / before the date
+		if (findRateOnOrBefore(date, rate) == false)
 		{
 			std::cerr << "Error: bad input => " << line << std::endl;
 			continue;
 		}
-		std::string	date = trim(line.substr(0, bar));
-		std::string	valueStr = trim(line.substr(bar + 1));
-		
-		double	value = 0.0;
-		double	rate = 0.0;
-		if (checkAndFetchRate(line, date, valueStr, value, rate) == false)
-			continue;
 		double	result = value * rate;
 		std::cout << date << " => " << valueStr << " = " << formater(result) << std::endl;
 	}
 }
 
+/*
+	Same input format, converted into every target currency in one pass.
+	Targets must be built first (buildConversionPath).
+	2011-01-03 => 3 = 0.45 EUR
+*/
+void	BitcoinExchange::loadInputFile(const std::string &filepath,
+										const std::vector<std::string> &targets)
+{
+	std::ifstream	file;
+	if (openInputFile(filepath, file) == false)
+		return ;
+
+	std::string	line;
+	std::string	date;
+	std::string	valueStr;
+	while (std::getline(file, line))
+	{
+		if (line.empty())
+			continue ;
+
+		double	value = 0.0;
+		if (parseInputLine(line, date, valueStr, value) == false)
+			continue;
+		for (size_t i = 0; i < targets.size(); i++)
+		{
+			double	rate = 0.0;
+			if (findConvertedRateOnOrBefore(targets[i], date, rate) == false)
+			{
+				std::cerr << "Error: bad input => " << line << std::endl;
+				continue;
+			}
+			std::cout << date << " => " << valueStr << " = "
+						<< formater(value * rate) << " " << targets[i] << std::endl;
+		}
+	}
+}
 
 // =============================================================================
 // Helper
@@ -293,7 +703,7 @@ void	BitcoinExchange::loadInputFile(const std::string &filepath)
 /*
 	trim leading and trailing spaces, tabs, carriage return, newline, and vertical tab (" \t\r\n\v").
 */
-std::string	BitcoinExchange::trim(const std::string &str)
+std::string	BitcoinExchange::trim(const std::string &str) const
 {
 	size_t	start = str.find_first_not_of(" \t\n\r\f\v");
 	size_t	end = str.find_last_not_of(" \t\n\r\f\v");
@@ -309,7 +719,7 @@ std::string	BitcoinExchange::trim(const std::string &str)
 /*
 	check the whole string, return true if all strings are digits
 */
-bool	BitcoinExchange::isDigits(const std::string &str)
+bool	BitcoinExchange::isDigits(const std::string &str) const
 {
 	if (str.size() <= 0)
 		return (false);
@@ -321,7 +731,7 @@ bool	BitcoinExchange::isDigits(const std::string &str)
 	return (true);
 }
 
-bool	BitcoinExchange::isLeapYear(int year)
+bool	BitcoinExchange::isLeapYear(int year) const
 {
 	// multiple of 4 → maybe leap; check century rule
 	if (year % 4 == 0)
@@ -347,7 +757,7 @@ bool	BitcoinExchange::isLeapYear(int year)
 	Month must have two values
 	Day also must have two values
 */
-bool	BitcoinExchange::isValidDate(const std::string &str)
+bool	BitcoinExchange::isValidDate(const std::string &str) const
 {
 	if (str.size() != 10 || str[4] != '-' || str[7] != '-')
 		return (false);
@@ -373,14 +783,14 @@ bool	BitcoinExchange::isValidDate(const std::string &str)
 		return (false);
 }
 
-bool	BitcoinExchange::isValidMonth(const int month)
+bool	BitcoinExchange::isValidMonth(const int month) const
 {
 	if (month < 1 || month > 12)
 		return (false);
 	return (true);
 }
 
-bool	BitcoinExchange::isValidYear(const int year)
+bool	BitcoinExchange::isValidYear(const int year) const
 {
 	if (year <= 0 || year >= INT_MAX)
 		return (false);
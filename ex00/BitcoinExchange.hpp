@@ -21,13 +21,48 @@
 # include <stdlib.h> // for strtod
 # include <cerrno> // for errno/ERANGE
 # include <cctype> // std::isdigit
+# include <vector>
+# include <algorithm> // std::sort
+# include <pthread.h> // one parser thread per shard
+# include <dirent.h> // opendir/readdir for shard directories
+# include <queue> // BFS over rate tables
+
+// data.csv is the BTC price in USD
+# define BASE_CURRENCY "BTC"
+# define QUOTE_CURRENCY "USD"
 
 
 class	BitcoinExchange
 {
 	private:
 		std::map<std::string, double>	_database;
+		size_t							_shardOverlapCount; // dates found in more than one shard
 
+		// One shard = one CSV file parsed on its own thread into a sorted run
+		struct CSVShard
+		{
+			const BitcoinExchange			*owner;
+			std::string						path;
+			std::map<std::string, double>	run;
+			bool							opened;
+		};
+		static void	*parseShardRoutine(void *arg);
+		void	mergeShardRuns(std::vector<CSVShard> &shards);
+
+		// Extra rate tables, key "FROM/TO" (e.g. "USD/EUR"), value date -> rate
+		std::map<std::string, std::map<std::string, double> >	_rateTables;
+		// BTC -> currency series, already joined along the conversion path
+		std::map<std::string, std::map<std::string, double> >	_joinedRates;
+
+		// One hop of a conversion path: a rate table, read as-is or inverted
+		struct RateHop
+		{
+			const std::map<std::string, double>	*table;
+			bool								inverted;
+		};
+		bool	findConversionPath(const std::string &target, std::vector<RateHop> &hops) const;
+		void	joinRateSeries(const std::vector<RateHop> &hops,
+								std::map<std::string, double> &joined) const;
 
 	public:
 		BitcoinExchange();
@@ -37,28 +72,44 @@ class	BitcoinExchange
 
 		// CSV File : aim to get the rate/price
 		bool	loadCSVFile(const std::string &filepath);
-		bool	parseCSVLine(std::string &line, std::string &date, double &price);
-		bool	parsePrice(std::string &price_str, double &price);
+		bool	parseCSVLine(std::string &line, std::string &date, double &price) const;
+		bool	parsePrice(std::string &price_str, double &price) const;
+		bool	parseCSVShard(const std::string &filepath, std::map<std::string, double> &run) const;
+
+		// Sharded CSV : several files (e.g. one per year), parsed in parallel
+		bool	loadCSVShards(const std::vector<std::string> &filepaths);
+		bool	loadCSVDirectory(const std::string &dirpath);
+		size_t	getShardOverlapCount() const;
+
+		// Cross-currency : BTC -> USD -> EUR ... precomputed into one series
+		bool	loadRateTable(const std::string &from, const std::string &to,
+							const std::string &filepath);
+		bool	buildConversionPath(const std::string &target);
+		bool	findConvertedRateOnOrBefore(const std::string &target,
+											const std::string &date,
+											double &rate) const;
 
 		// File Parser
 		void	loadInputFile(const std::string &filepath);
-		bool	checkAndFetchRate(const std::string &rawLine,
-								const std::string &date,
-								const std::string &valueStr,
-								double &value,
-								double &rate);
-		bool	parseValue(const std::string &valueStr, double &value);
+		void	loadInputFile(const std::string &filepath,
+							const std::vector<std::string> &targets);
+		bool	openInputFile(const std::string &filepath, std::ifstream &file);
+		bool	parseInputLine(const std::string &line,
+								std::string &date,
+								std::string &valueStr,
+								double &value);
+		bool	parseValue(const std::string &valueStr, double &value) const;
 		bool	checkValue(const double &value);
 		bool	findRateOnOrBefore(const std::string &date, double &rate) const;
-		std::string	formater(double x);
+		std::string	formater(double x) const;
 
 		// Helper
-		std::string	trim(const std::string &str);
-		bool	isValidDate(const std::string &str);
-		bool	isDigits(const std::string &str);
-		bool	isLeapYear(int year);
-		bool	isValidMonth(const int month);
-		bool	isValidYear(const int year);
+		std::string	trim(const std::string &str) const;
+		bool	isValidDate(const std::string &str) const;
+		bool	isDigits(const std::string &str) const;
+		bool	isLeapYear(int year) const;
+		bool	isValidMonth(const int month) const;
+		bool	isValidYear(const int year) const;
 		bool	isInputFileHeader(const std::string &line);
 
 
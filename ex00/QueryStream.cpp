@@ -0,0 +1,175 @@
+#include "QueryStream.hpp"
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operators
+// =============================================================================
+
+QueryStream::Sink::~Sink() {}
+
+QueryStream::QueryStream(const BitcoinExchange &exchange, Sink &sink):
+	_exchange(&exchange),
+	_sink(&sink),
+	_carry(),
+	_headerChecked(false),
+	_date(),
+	_value()
+{}
+
+QueryStream::~QueryStream() {}
+
+QueryStream::QueryStream(const QueryStream &other):
+	_exchange(other._exchange),
+	_sink(other._sink),
+	_carry(other._carry),
+	_headerChecked(other._headerChecked),
+	_date(other._date),
+	_value(other._value)
+{}
+
+QueryStream	&QueryStream::operator=(const QueryStream &other)
+{
+	if (this != &other)
+	{
+		this->_exchange = other._exchange;
+		this->_sink = other._sink;
+		this->_carry = other._carry;
+		this->_headerChecked = other._headerChecked;
+		this->_date = other._date;
+		this->_value = other._value;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// Stream
+// =============================================================================
+
+/*
+	chunk:  "...| 3\n2011-01-09 | 1\n2012-0"
+	         ^carry  ^complete line   ^new carry
+
+	1. finish the carried line with the bytes up to the first '\n'
+	2. parse every complete line in place
+	3. keep the tail for the next feed
+*/
+void	QueryStream::feed(const char *chunk, size_t size)
+{
+	const char	*cursor = chunk;
+	const char	*end = chunk + size;
+
+	if (!_carry.empty())
+	{
+		const char	*newline = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+		if (newline == 0)
+		{
+			_carry.insert(_carry.end(), cursor, end);
+			return ;
+		}
+		_carry.insert(_carry.end(), cursor, newline);
+		processLine(&_carry[0], _carry.size());
+		_carry.clear(); // keeps its capacity
+		cursor = newline + 1;
+	}
+	while (cursor < end)
+	{
+		const char	*newline = static_cast<const char *>(std::memchr(cursor, '\n', end - cursor));
+		if (newline == 0)
+		{
+			_carry.insert(_carry.end(), cursor, end);
+			return ;
+		}
+		processLine(cursor, newline - cursor);
+		cursor = newline + 1;
+	}
+}
+
+/*
+	End of input: a last line without '\n' is still a line (like getline)
+*/
+void	QueryStream::finish()
+{
+	if (!_carry.empty())
+	{
+		processLine(&_carry[0], _carry.size());
+		_carry.clear();
+	}
+	_headerChecked = false;
+}
+
+/*
+	Same rules and messages as loadInputFile / checkAndFetchRate
+*/
+void	QueryStream::processLine(const char *line, size_t len)
+{
+	const char	*lineEnd = line + len;
+	if (_headerChecked == false)
+	{
+		_headerChecked = true; // only the first line, even empty, may be the header
+		const char	*begin = line;
+		const char	*end = lineEnd;
+		trimRange(begin, end);
+		if (end - begin == 12 && std::memcmp(begin, "date | value", 12) == 0)
+			return ;
+	}
+	if (len == 0)
+		return ;
+
+	const char	*bar = static_cast<const char *>(std::memchr(line, '|', len));
+	if (bar == 0)
+	{
+		_sink->onError(ERROR_BAD_INPUT, line, len);
+		return ;
+	}
+	const char	*dateBegin = line;
+	const char	*dateEnd = bar;
+	const char	*valueBegin = bar + 1;
+	const char	*valueEnd = lineEnd;
+	trimRange(dateBegin, dateEnd);
+	trimRange(valueBegin, valueEnd);
+
+	_date.assign(dateBegin, dateEnd);
+	_value.assign(valueBegin, valueEnd);
+	double	value = 0.0;
+	if (_exchange->isValidDate(_date) == false
+		|| _exchange->parseValue(_value, value) == false)
+	{
+		_sink->onError(ERROR_BAD_INPUT, line, len);
+		return ;
+	}
+	if (value < 0.0)
+	{
+		_sink->onError(ERROR_NOT_POSITIVE, line, len);
+		return ;
+	}
+	if (value > 1000.0)
+	{
+		_sink->onError(ERROR_TOO_LARGE, line, len);
+		return ;
+	}
+	double	rate = 0.0;
+	if (_exchange->findRateOnOrBefore(_date, rate) == false)
+	{
+		_sink->onError(ERROR_BAD_INPUT, line, len);
+		return ;
+	}
+	_sink->onResult(dateBegin, dateEnd - dateBegin,
+					valueBegin, valueEnd - valueBegin,
+					value * rate);
+}
+
+// =============================================================================
+// Helper
+// =============================================================================
+
+void	QueryStream::trimRange(const char *&begin, const char *&end) const
+{
+	while (begin < end && isBlank(*begin))
+		begin++;
+	while (end > begin && isBlank(*(end - 1)))
+		end--;
+}
+
+bool	QueryStream::isBlank(char c) const
+{
+	return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v');
+}
@@ -0,0 +1,70 @@
+#ifndef QUERYSTREAM_HPP
+# define QUERYSTREAM_HPP
+
+# include "BitcoinExchange.hpp"
+# include <cstring> // memchr, memcpy
+
+/*
+	Push-based version of BitcoinExchange::loadInputFile.
+
+	The caller pushes bytes in chunks of any size (socket, pipe, ...),
+	lines may be split across chunks. Every query line ("date | value")
+	ends up as one callback on the caller's Sink, nothing is printed.
+
+	No std::string is built per line:
+	- complete lines are parsed in place, straight from the chunk
+	- only the unfinished tail of a chunk is kept in a reused carry buffer
+	- the date and the value go into reused strings (no reallocation once
+	  they are long enough), the value is read by BitcoinExchange::parseValue
+	  like in loadInputFile
+
+	QueryStream stream(exchange, sink);
+	stream.feed("2011-01-03 | 3\n2011-0", 21);
+	stream.feed("1-09 | 1\n", 9);
+	stream.finish(); // flush a last line without '\n'
+*/
+class	QueryStream
+{
+	public:
+		enum ErrorKind
+		{
+			ERROR_BAD_INPUT,		// "Error: bad input => <line>"
+			ERROR_NOT_POSITIVE,		// "Error: not a positive number."
+			ERROR_TOO_LARGE			// "Error: too large a number."
+		};
+
+		// Pointers are only valid during the callback
+		class	Sink
+		{
+			public:
+				virtual	~Sink();
+				virtual void	onResult(const char *date, size_t dateLen,
+										const char *value, size_t valueLen,
+										double result) = 0;
+				virtual void	onError(ErrorKind kind, const char *line, size_t lineLen) = 0;
+		};
+
+		QueryStream(const BitcoinExchange &exchange, Sink &sink);
+		~QueryStream();
+		QueryStream(const QueryStream &other);
+		QueryStream	&operator=(const QueryStream &other);
+
+		void	feed(const char *chunk, size_t size);
+		void	finish();
+
+	private:
+		QueryStream();
+
+		const BitcoinExchange	*_exchange;
+		Sink					*_sink;
+		std::vector<char>		_carry; // unfinished line from the previous chunk
+		bool					_headerChecked;
+		std::string				_date;
+		std::string				_value;
+
+		void	processLine(const char *line, size_t len);
+		void	trimRange(const char *&begin, const char *&end) const;
+		bool	isBlank(char c) const;
+};
+
+#endif
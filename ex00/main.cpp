@@ -1,4 +1,6 @@
 #include "BitcoinExchange.hpp"
+#include "QueryStream.hpp"
+#include <unistd.h> // read
 
 /*
 	data.csv
@@ -17,21 +19,167 @@
 	2001-42-42
 
 	std::map has lower_bound and keys are unique
+
+	Sharded database (optional, default is data.csv)
+	./btc input.txt db/2011.csv db/2012.csv   -> shards, later file wins on a repeated date
+	./btc input.txt db/                       -> every *.csv of the directory, in name order
+
+	Cross-currency (optional, repeatable)
+	./btc input.txt --rate USD/EUR=usd_eur.csv --rate EUR/JPY=eur_jpy.csv --to EUR --to JPY
+
+	Streaming (stdin pushed chunk by chunk through QueryStream)
+	cat input.txt | ./btc -
+	USD only: QueryStream has no target currency, `./btc - --to EUR` is
+	rejected instead of opening a file named "-"
 */
 
+/*
+	Prints exactly what loadInputFile prints
+*/
+class	ConsoleSink: public QueryStream::Sink
+{
+	public:
+		ConsoleSink(const BitcoinExchange &exchange): _exchange(exchange) {}
+
+		virtual void	onResult(const char *date, size_t dateLen,
+								const char *value, size_t valueLen,
+								double result)
+		{
+			std::cout.write(date, dateLen);
+			std::cout << " => ";
+			std::cout.write(value, valueLen);
+			std::cout << " = " << _exchange.formater(result) << std::endl;
+		}
+
+		virtual void	onError(QueryStream::ErrorKind kind, const char *line, size_t lineLen)
+		{
+			if (kind == QueryStream::ERROR_NOT_POSITIVE)
+				std::cerr << "Error: not a positive number." << std::endl;
+			else if (kind == QueryStream::ERROR_TOO_LARGE)
+				std::cerr << "Error: too large a number." << std::endl;
+			else
+			{
+				std::cerr << "Error: bad input => ";
+				std::cerr.write(line, lineLen);
+				std::cerr << std::endl;
+			}
+		}
+
+	private:
+		const BitcoinExchange	&_exchange;
+};
+
+static void	streamStandardInput(const BitcoinExchange &be)
+{
+	ConsoleSink	sink(be);
+	QueryStream	stream(be, sink);
+	char		buffer[4096];
+	ssize_t		bytes;
+
+	while ((bytes = read(0, buffer, sizeof(buffer))) > 0)
+		stream.feed(buffer, static_cast<size_t>(bytes));
+	stream.finish();
+}
+
+static bool	isDirectory(const char *path)
+{
+	DIR	*dir = opendir(path);
+	if (dir == 0)
+		return (false);
+	closedir(dir);
+	return (true);
+}
+
+struct Options
+{
+	std::vector<std::string>	shards;
+	std::vector<std::string>	rates; // "FROM/TO=path"
+	std::vector<std::string>	targets;
+};
+
+static bool	parseOptions(int ac, char **av, Options &options)
+{
+	for (int i = 2; i < ac; i++)
+	{
+		std::string	arg(av[i]);
+		if (arg == "--rate" || arg == "--to")
+		{
+			if (i + 1 >= ac)
+				return (false);
+			if (arg == "--rate")
+				options.rates.push_back(av[++i]);
+			else
+				options.targets.push_back(av[++i]);
+		}
+		else
+			options.shards.push_back(arg);
+	}
+	return (true);
+}
+
+static bool	loadDatabase(BitcoinExchange &be, const Options &options)
+{
+	if (options.shards.empty())
+		return (be.loadCSVFile("data.csv"));
+	if (options.shards.size() == 1 && isDirectory(options.shards[0].c_str()))
+		return (be.loadCSVDirectory(options.shards[0]));
+	return (be.loadCSVShards(options.shards));
+}
+
+static bool	loadConversions(BitcoinExchange &be, const Options &options)
+{
+	for (size_t i = 0; i < options.rates.size(); i++)
+	{
+		const std::string	&rate = options.rates[i];
+		std::string::size_type	slash = rate.find('/');
+		std::string::size_type	equal = rate.find('=');
+		if (slash == std::string::npos || equal == std::string::npos || slash > equal)
+			return (false);
+		if (be.loadRateTable(rate.substr(0, slash),
+							rate.substr(slash + 1, equal - slash - 1),
+							rate.substr(equal + 1)) == false)
+			return (false);
+	}
+	for (size_t i = 0; i < options.targets.size(); i++)
+	{
+		if (be.buildConversionPath(options.targets[i]) == false)
+			return (false);
+	}
+	return (true);
+}
+
 int main(int ac, char **av)
 {
-	if (ac != 2)
+	Options	options;
+	if (ac < 2 || parseOptions(ac, av, options) == false)
 	{
 		std::cerr << "Error: could not open file." << std::endl;
 		return (1);
 	}
+	if (std::string(av[1]) == "-" && options.targets.empty() == false)
+	{
+		std::cerr << "Error: --to needs an input file, not stdin." << std::endl;
+		return (1);
+	}
 	BitcoinExchange	be;
-	if (be.loadCSVFile("data.csv") == false)
+	if (loadDatabase(be, options) == false)
 	{
 		std::cerr << "Error: could not open file." << std::endl;
 		return (1);
 	}
-	be.loadInputFile(av[1]);
+	if (be.getShardOverlapCount() > 0)
+		std::cerr << "Warning: " << be.getShardOverlapCount()
+					<< " date(s) found in several shards, last shard wins." << std::endl;
+	if (loadConversions(be, options) == false)
+	{
+		std::cerr << "Error: could not build conversion path." << std::endl;
+		return (1);
+	}
+	if (std::string(av[1]) == "-")
+		streamStandardInput(be);
+	else if (options.targets.empty())
+		be.loadInputFile(av[1]);
+	else
+		be.loadInputFile(av[1], options.targets);
 	return (0);
-}
\ No newline at end of file
+}
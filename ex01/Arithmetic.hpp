@@ -0,0 +1,288 @@
+#ifndef ARITHMETIC_HPP
+# define ARITHMETIC_HPP
+
+#include <climits> // LONG_MAX, LONG_MIN
+
+/*
+	Arithmetic policies for RPN::evaluateWith<Policy>.
+
+	Every policy has the same static interface, all inline, so the
+	evaluation loop instantiated for one policy contains only its code:
+		fromLong(v)          operand (constant / variable) -> internal value
+		toLong(v)            internal value -> result
+		add/sub/mul/div(a, b, out)   false = this row fails
+
+	Checked    : the subject rules, overflow and division by zero fail
+	Wrapping   : two's complement, like unsigned arithmetic; only / 0 fails
+	             (LONG_MIN / -1 wraps to LONG_MIN)
+	Saturating : clamp to [LONG_MIN, LONG_MAX]; only / 0 fails
+	             (LONG_MIN / -1 gives LONG_MAX)
+	Modular    : integers mod P = 1000000007, the result is in [0, P).
+	             a / b is a * b^-1, b = 0 (mod P) fails.
+	             Values are kept in Montgomery form (v * 2^32 mod P), so a
+	             product is one 64 bit multiply and one reduction (redc),
+	             no 64 bit division.
+*/
+
+// =============================================================================
+// Checked (the RPN::safe* rules)
+// =============================================================================
+
+struct	CheckedArithmetic
+{
+	static long	fromLong(long value)
+	{
+		return (value);
+	}
+
+	static long	toLong(long value)
+	{
+		return (value);
+	}
+
+	static bool	add(long a, long b, long &out)
+	{
+		if (b > 0)
+		{
+			if (a > LONG_MAX - b)
+				return (false);
+		}
+		else if (b < 0)
+		{
+			if (a < LONG_MIN - b)
+				return (false);
+		}
+		out = a + b;
+		return (true);
+	}
+
+	static bool	sub(long a, long b, long &out)
+	{
+		if (b > 0)
+		{
+			if (a < LONG_MIN + b)
+				return (false);
+		}
+		else if (b < 0)
+		{
+			if (a > LONG_MAX + b) // a - b > LONG_MAX, with -b > 0
+				return (false);
+		}
+		out = a - b;
+		return (true);
+	}
+
+	// |a * b| must fit: compare against LONG_MAX / LONG_MIN divided by one side
+	static bool	mul(long a, long b, long &out)
+	{
+		if (a == 0 || b == 0)
+		{
+			out = 0;
+			return (true);
+		}
+		if (a > 0)
+		{
+			if (b > 0 && a > LONG_MAX / b)
+				return (false);
+			if (b < 0 && b < LONG_MIN / a)
+				return (false);
+		}
+		else
+		{
+			if (b > 0 && a < LONG_MIN / b)
+				return (false);
+			if (b < 0 && a < LONG_MAX / b)
+				return (false);
+		}
+		out = a * b;
+		return (true);
+	}
+
+	static bool	div(long a, long b, long &out)
+	{
+		if (b == 0)
+			return (false);
+		if (a == LONG_MIN && b == -1) // +2^63 does not fit
+			return (false);
+		out = a / b;
+		return (true);
+	}
+};
+
+// =============================================================================
+// Wrapping
+// =============================================================================
+
+struct	WrappingArithmetic
+{
+	static long	fromLong(long value)
+	{
+		return (value);
+	}
+
+	static long	toLong(long value)
+	{
+		return (value);
+	}
+
+	// unsigned overflow is defined, the cast back is two's complement on gcc/clang
+	static bool	add(long a, long b, long &out)
+	{
+		out = static_cast<long>(static_cast<unsigned long>(a) + static_cast<unsigned long>(b));
+		return (true);
+	}
+
+	static bool	sub(long a, long b, long &out)
+	{
+		out = static_cast<long>(static_cast<unsigned long>(a) - static_cast<unsigned long>(b));
+		return (true);
+	}
+
+	static bool	mul(long a, long b, long &out)
+	{
+		out = static_cast<long>(static_cast<unsigned long>(a) * static_cast<unsigned long>(b));
+		return (true);
+	}
+
+	static bool	div(long a, long b, long &out)
+	{
+		if (b == 0)
+			return (false);
+		if (b == -1)
+			return (sub(0, a, out)); // LONG_MIN / -1 traps in idiv
+		out = a / b;
+		return (true);
+	}
+};
+
+// =============================================================================
+// Saturating
+// =============================================================================
+
+struct	SaturatingArithmetic
+{
+	static long	fromLong(long value)
+	{
+		return (value);
+	}
+
+	static long	toLong(long value)
+	{
+		return (value);
+	}
+
+	static bool	add(long a, long b, long &out)
+	{
+		if (__builtin_add_overflow(a, b, &out))
+			out = (b > 0) ? LONG_MAX : LONG_MIN;
+		return (true);
+	}
+
+	static bool	sub(long a, long b, long &out)
+	{
+		if (__builtin_sub_overflow(a, b, &out))
+			out = (b < 0) ? LONG_MAX : LONG_MIN;
+		return (true);
+	}
+
+	static bool	mul(long a, long b, long &out)
+	{
+		if (__builtin_mul_overflow(a, b, &out))
+			out = ((a < 0) != (b < 0)) ? LONG_MIN : LONG_MAX;
+		return (true);
+	}
+
+	static bool	div(long a, long b, long &out)
+	{
+		if (b == 0)
+			return (false);
+		if (a == LONG_MIN && b == -1)
+			out = LONG_MAX;
+		else
+			out = a / b;
+		return (true);
+	}
+};
+
+// =============================================================================
+// Modular (Montgomery, R = 2^32)
+// =============================================================================
+
+/*
+	redc(T) = T * R^-1 mod P, for T < P * R:
+		m = (T mod R) * (-P^-1 mod R) mod R
+		(T + m * P) is a multiple of R, divide by shifting
+	P < 2^30, so T + m * P < 2^63: everything fits an unsigned long.
+*/
+struct	ModularArithmetic
+{
+	static const unsigned long	P = 1000000007UL;
+	static const unsigned long	NEG_P_INVERSE = 0x84B77C49UL;	// -P^-1 mod 2^32
+	static const unsigned long	R_SQUARED = 582344008UL;		// 2^64 mod P
+
+	static unsigned long	redc(unsigned long t)
+	{
+		unsigned long	m = ((t & 0xFFFFFFFFUL) * NEG_P_INVERSE) & 0xFFFFFFFFUL;
+		unsigned long	reduced = (t + m * P) >> 32;
+		if (reduced >= P)
+			reduced -= P;
+		return (reduced);
+	}
+
+	static long	fromLong(long value)
+	{
+		long	residue = value % static_cast<long>(P);
+		if (residue < 0)
+			residue += static_cast<long>(P);
+		return (static_cast<long>(redc(static_cast<unsigned long>(residue) * R_SQUARED)));
+	}
+
+	static long	toLong(long value)
+	{
+		return (static_cast<long>(redc(static_cast<unsigned long>(value))));
+	}
+
+	static bool	add(long a, long b, long &out)
+	{
+		long	sum = a + b;
+		if (sum >= static_cast<long>(P))
+			sum -= static_cast<long>(P);
+		out = sum;
+		return (true);
+	}
+
+	static bool	sub(long a, long b, long &out)
+	{
+		long	difference = a - b;
+		if (difference < 0)
+			difference += static_cast<long>(P);
+		out = difference;
+		return (true);
+	}
+
+	static bool	mul(long a, long b, long &out)
+	{
+		out = static_cast<long>(redc(static_cast<unsigned long>(a) * static_cast<unsigned long>(b)));
+		return (true);
+	}
+
+	// b^-1 = b^(P-2) (Fermat), square and multiply in Montgomery form
+	static bool	div(long a, long b, long &out)
+	{
+		if (b == 0)
+			return (false);
+		long			inverse = fromLong(1);
+		long			base = b;
+		unsigned long	exponent = P - 2;
+		while (exponent > 0)
+		{
+			if (exponent & 1)
+				mul(inverse, base, inverse);
+			mul(base, base, base);
+			exponent >>= 1;
+		}
+		return (mul(a, inverse, out));
+	}
+};
+
+#endif
@@ -0,0 +1,442 @@
+#include "BigInt.hpp"
+#include <algorithm> // std::reverse
+
+#define LIMB_BITS 32
+#define LIMB_BASE 4294967296UL
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+BigInt::BigInt():
+	_limbs(),
+	_negative(false)
+{}
+
+BigInt::BigInt(long value):
+	_limbs(),
+	_negative(value < 0)
+{
+	// -(LONG_MIN) does not fit a long, go through unsigned long
+	unsigned long	magnitude = static_cast<unsigned long>(value);
+	if (_negative)
+		magnitude = 0UL - magnitude;
+	while (magnitude != 0)
+	{
+		_limbs.push_back(static_cast<unsigned int>(magnitude & 0xFFFFFFFFUL));
+		magnitude >>= LIMB_BITS;
+	}
+}
+
+BigInt::~BigInt()
+{}
+
+BigInt::BigInt(const BigInt &other):
+	_limbs(other._limbs),
+	_negative(other._negative)
+{}
+
+BigInt	&BigInt::operator=(const BigInt &other)
+{
+	if (this != &other)
+	{
+		this->_limbs = other._limbs;
+		this->_negative = other._negative;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// Arithmetic
+// =============================================================================
+
+/*
+	Same signs      -> add magnitudes, keep the sign
+	Different signs -> subtract the smaller magnitude from the bigger,
+	                   take the sign of the bigger
+*/
+BigInt	BigInt::operator+(const BigInt &rhs) const
+{
+	BigInt	result;
+	if (_negative == rhs._negative)
+	{
+		addMagnitude(_limbs, rhs._limbs, result._limbs);
+		result._negative = _negative;
+	}
+	else if (compareMagnitude(_limbs, rhs._limbs) >= 0)
+	{
+		subMagnitude(_limbs, rhs._limbs, result._limbs);
+		result._negative = _negative;
+	}
+	else
+	{
+		subMagnitude(rhs._limbs, _limbs, result._limbs);
+		result._negative = rhs._negative;
+	}
+	result.normalise();
+	return (result);
+}
+
+BigInt	BigInt::operator-(const BigInt &rhs) const
+{
+	BigInt	negated(rhs);
+	if (!negated.isZero())
+		negated._negative = !negated._negative;
+	return (*this + negated);
+}
+
+BigInt	BigInt::operator*(const BigInt &rhs) const
+{
+	BigInt	result;
+	mulMagnitude(_limbs, rhs._limbs, result._limbs);
+	result._negative = (_negative != rhs._negative);
+	result.normalise();
+	return (result);
+}
+
+/*
+	Truncates toward zero: -7 / 2 = -3, like long
+*/
+bool	BigInt::divide(const BigInt &divisor, BigInt &quotient) const
+{
+	if (divisor.isZero())
+		return (false);
+	BigInt	result;
+	divideMagnitude(_limbs, divisor._limbs, result._limbs);
+	result._negative = (_negative != divisor._negative);
+	result.normalise();
+	quotient = result;
+	return (true);
+}
+
+bool	BigInt::isZero() const
+{
+	return (_limbs.empty());
+}
+
+size_t	BigInt::limbCount() const
+{
+	return (_limbs.size());
+}
+
+/*
+	Peel 9 decimal digits at a time (divide by 10^9)
+*/
+std::string	BigInt::toString() const
+{
+	if (isZero())
+		return ("0");
+	Limbs		value(_limbs);
+	std::string	digits;
+	while (!value.empty())
+	{
+		unsigned int	chunk = divideSmall(value, 1000000000U);
+		for (int i = 0; i < 9; i++)
+		{
+			digits += static_cast<char>('0' + chunk % 10);
+			chunk /= 10;
+			if (value.empty() && chunk == 0)
+				break;
+		}
+	}
+	if (_negative)
+		digits += '-';
+	std::reverse(digits.begin(), digits.end());
+	return (digits);
+}
+
+// =============================================================================
+// Magnitude Helper
+// =============================================================================
+
+void	BigInt::normalise()
+{
+	trim(_limbs);
+	if (_limbs.empty())
+		_negative = false;
+}
+
+void	BigInt::trim(Limbs &limbs)
+{
+	while (!limbs.empty() && limbs[limbs.size() - 1] == 0)
+		limbs.pop_back();
+}
+
+int	BigInt::compareMagnitude(const Limbs &a, const Limbs &b)
+{
+	if (a.size() != b.size())
+		return (a.size() < b.size() ? -1 : 1);
+	size_t	i = a.size();
+	while (i > 0)
+	{
+		i--;
+		if (a[i] != b[i])
+			return (a[i] < b[i] ? -1 : 1);
+	}
+	return (0);
+}
+
+void	BigInt::addMagnitude(const Limbs &a, const Limbs &b, Limbs &out)
+{
+	const Limbs	&longer = (a.size() >= b.size()) ? a : b;
+	const Limbs	&shorter = (a.size() >= b.size()) ? b : a;
+	Limbs		sum(longer.size() + 1, 0);
+	unsigned long	carry = 0;
+	for (size_t i = 0; i < longer.size(); i++)
+	{
+		unsigned long	digit = static_cast<unsigned long>(longer[i]) + carry;
+		if (i < shorter.size())
+			digit += shorter[i];
+		sum[i] = static_cast<unsigned int>(digit);
+		carry = digit >> LIMB_BITS;
+	}
+	sum[longer.size()] = static_cast<unsigned int>(carry);
+	trim(sum);
+	out.swap(sum);
+}
+
+void	BigInt::subMagnitude(const Limbs &a, const Limbs &b, Limbs &out)
+{
+	Limbs	difference(a.size(), 0);
+	long	borrow = 0;
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		long	digit = static_cast<long>(a[i]) - borrow;
+		if (i < b.size())
+			digit -= static_cast<long>(b[i]);
+		borrow = 0;
+		if (digit < 0)
+		{
+			digit += static_cast<long>(LIMB_BASE);
+			borrow = 1;
+		}
+		difference[i] = static_cast<unsigned int>(digit);
+	}
+	trim(difference);
+	out.swap(difference);
+}
+
+/*
+	acc += value * BASE^shift
+*/
+void	BigInt::addShifted(Limbs &acc, const Limbs &value, size_t shift)
+{
+	if (acc.size() < value.size() + shift + 1)
+		acc.resize(value.size() + shift + 1, 0);
+	unsigned long	carry = 0;
+	size_t			i = 0;
+	for (; i < value.size(); i++)
+	{
+		unsigned long	digit = static_cast<unsigned long>(acc[i + shift]) + value[i] + carry;
+		acc[i + shift] = static_cast<unsigned int>(digit);
+		carry = digit >> LIMB_BITS;
+	}
+	for (i += shift; carry != 0; i++)
+	{
+		if (i == acc.size())
+			acc.push_back(0);
+		unsigned long	digit = static_cast<unsigned long>(acc[i]) + carry;
+		acc[i] = static_cast<unsigned int>(digit);
+		carry = digit >> LIMB_BITS;
+	}
+}
+
+void	BigInt::mulMagnitude(const Limbs &a, const Limbs &b, Limbs &out)
+{
+	if (a.empty() || b.empty())
+	{
+		out.clear();
+		return ;
+	}
+	if (a.size() < KARATSUBA_THRESHOLD || b.size() < KARATSUBA_THRESHOLD)
+		mulSchoolbook(a, b, out);
+	else
+		mulKaratsuba(a, b, out);
+}
+
+void	BigInt::mulSchoolbook(const Limbs &a, const Limbs &b, Limbs &out)
+{
+	Limbs	product(a.size() + b.size(), 0);
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		unsigned long	carry = 0;
+		unsigned long	ai = a[i];
+		for (size_t j = 0; j < b.size(); j++)
+		{
+			unsigned long	digit = ai * b[j] + product[i + j] + carry;
+			product[i + j] = static_cast<unsigned int>(digit);
+			carry = digit >> LIMB_BITS;
+		}
+		product[i + b.size()] = static_cast<unsigned int>(carry);
+	}
+	trim(product);
+	out.swap(product);
+}
+
+/*
+	Split at m limbs:  a = a1 * B^m + a0,  b = b1 * B^m + b0
+		z0 = a0 * b0
+		z2 = a1 * b1
+		z1 = (a0 + a1) * (b0 + b1) - z0 - z2
+		a * b = z2 * B^2m + z1 * B^m + z0
+	3 half-size products instead of 4.
+
+	Very unbalanced sizes (b fits in the low half): a0*b + a1*b * B^m
+*/
+void	BigInt::mulKaratsuba(const Limbs &a, const Limbs &b, Limbs &out)
+{
+	size_t	m = std::max(a.size(), b.size()) / 2;
+	Limbs	a0(a.begin(), a.begin() + std::min(m, a.size()));
+	Limbs	a1;
+	if (a.size() > m)
+		a1.assign(a.begin() + m, a.end());
+	trim(a0);
+
+	if (b.size() <= m)
+	{
+		Limbs	low;
+		Limbs	high;
+		mulMagnitude(a0, b, low);
+		mulMagnitude(a1, b, high);
+		addShifted(low, high, m);
+		trim(low);
+		out.swap(low);
+		return ;
+	}
+	Limbs	b0(b.begin(), b.begin() + m);
+	Limbs	b1(b.begin() + m, b.end());
+	trim(b0);
+
+	Limbs	z0;
+	Limbs	z2;
+	Limbs	sumA;
+	Limbs	sumB;
+	Limbs	z1;
+	mulMagnitude(a0, b0, z0);
+	mulMagnitude(a1, b1, z2);
+	addMagnitude(a0, a1, sumA);
+	addMagnitude(b0, b1, sumB);
+	mulMagnitude(sumA, sumB, z1);
+	subMagnitude(z1, z0, z1);
+	subMagnitude(z1, z2, z1);
+
+	Limbs	result(z0);
+	addShifted(result, z1, m);
+	addShifted(result, z2, 2 * m);
+	trim(result);
+	out.swap(result);
+}
+
+/*
+	value /= divisor, returns the remainder
+*/
+unsigned int	BigInt::divideSmall(Limbs &value, unsigned int divisor)
+{
+	unsigned long	remainder = 0;
+	size_t			i = value.size();
+	while (i > 0)
+	{
+		i--;
+		unsigned long	current = (remainder << LIMB_BITS) | value[i];
+		value[i] = static_cast<unsigned int>(current / divisor);
+		remainder = current % divisor;
+	}
+	trim(value);
+	return (static_cast<unsigned int>(remainder));
+}
+
+/*
+	Knuth, TAOCP vol.2, 4.3.1 algorithm D
+
+	1. normalise: shift u and v left so the top limb of v has its high bit
+	   set, then the estimate qhat below is off by at most 2
+	2. for each quotient limb, from the top:
+	   qhat = (u[j+n] * B + u[j+n-1]) / v[n-1], corrected with v[n-2]
+	   u -= qhat * v (shifted); if that went negative, add v back once
+*/
+void	BigInt::divideMagnitude(const Limbs &u, const Limbs &v, Limbs &quotient)
+{
+	if (compareMagnitude(u, v) < 0)
+	{
+		quotient.clear();
+		return ;
+	}
+	if (v.size() == 1)
+	{
+		quotient = u;
+		divideSmall(quotient, v[0]);
+		return ;
+	}
+
+	size_t	n = v.size();
+	size_t	m = u.size() - n;
+	int		shift = 0;
+	while ((v[n - 1] << shift & 0x80000000U) == 0)
+		shift++;
+
+	Limbs	vn(n, 0);
+	Limbs	un(u.size() + 1, 0);
+	for (size_t i = n - 1; i > 0; i--)
+		vn[i] = (v[i] << shift) | (shift ? static_cast<unsigned int>(static_cast<unsigned long>(v[i - 1]) >> (LIMB_BITS - shift)) : 0);
+	vn[0] = v[0] << shift;
+	un[u.size()] = shift ? static_cast<unsigned int>(static_cast<unsigned long>(u[u.size() - 1]) >> (LIMB_BITS - shift)) : 0;
+	for (size_t i = u.size() - 1; i > 0; i--)
+		un[i] = (u[i] << shift) | (shift ? static_cast<unsigned int>(static_cast<unsigned long>(u[i - 1]) >> (LIMB_BITS - shift)) : 0);
+	un[0] = u[0] << shift;
+
+	Limbs	q(m + 1, 0);
+	size_t	j = m + 1;
+	while (j > 0)
+	{
+		j--;
+		unsigned long	numerator = (static_cast<unsigned long>(un[j + n]) << LIMB_BITS) | un[j + n - 1];
+		unsigned long	qhat = numerator / vn[n - 1];
+		unsigned long	rhat = numerator % vn[n - 1];
+		while (qhat >= LIMB_BASE
+			|| qhat * vn[n - 2] > ((rhat << LIMB_BITS) | un[j + n - 2]))
+		{
+			qhat--;
+			rhat += vn[n - 1];
+			if (rhat >= LIMB_BASE)
+				break;
+		}
+
+		// un[j .. j+n] -= qhat * vn
+		long			borrow = 0;
+		unsigned long	carry = 0;
+		for (size_t i = 0; i < n; i++)
+		{
+			unsigned long	product = qhat * vn[i] + carry;
+			carry = product >> LIMB_BITS;
+			long	digit = static_cast<long>(un[i + j]) - borrow
+							- static_cast<long>(product & 0xFFFFFFFFUL);
+			borrow = 0;
+			if (digit < 0)
+			{
+				digit += static_cast<long>(LIMB_BASE);
+				borrow = 1;
+			}
+			un[i + j] = static_cast<unsigned int>(digit);
+		}
+		long	top = static_cast<long>(un[j + n]) - borrow - static_cast<long>(carry);
+		if (top < 0)
+		{
+			// qhat was one too big: add v back
+			un[j + n] = static_cast<unsigned int>(top + static_cast<long>(LIMB_BASE));
+			qhat--;
+			unsigned long	addCarry = 0;
+			for (size_t i = 0; i < n; i++)
+			{
+				unsigned long	sum = static_cast<unsigned long>(un[i + j]) + vn[i] + addCarry;
+				un[i + j] = static_cast<unsigned int>(sum);
+				addCarry = sum >> LIMB_BITS;
+			}
+			un[j + n] = static_cast<unsigned int>(un[j + n] + addCarry);
+		}
+		else
+			un[j + n] = static_cast<unsigned int>(top);
+		q[j] = static_cast<unsigned int>(qhat);
+	}
+	trim(q);
+	quotient.swap(q);
+}
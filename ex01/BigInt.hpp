@@ -0,0 +1,67 @@
+#ifndef BIGINT_HPP
+# define BIGINT_HPP
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+# ifndef KARATSUBA_THRESHOLD
+#  define KARATSUBA_THRESHOLD 32 // limbs, below that schoolbook is faster
+# endif
+
+/*
+	Arbitrary precision signed integer for RPN --big.
+
+	sign + magnitude, the magnitude is an array of 32 bit limbs,
+	least significant first (unsigned long holds a 64 bit product: LP64).
+
+		123456789012 = 28 * 2^32 + 3197704724  ->  limbs { 3197704724, 28 }
+
+	- add / sub    : O(n)
+	- mul          : schoolbook, Karatsuba once both sides reach
+	                 KARATSUBA_THRESHOLD limbs (O(n^1.585))
+	- divide       : Knuth long division (algorithm D), O(n * m),
+	                 truncates toward zero like long division in C
+	Zero has no limbs and is never negative.
+*/
+class	BigInt
+{
+	public:
+		BigInt();
+		BigInt(long value);
+		~BigInt();
+		BigInt(const BigInt &other);
+		BigInt	&operator=(const BigInt &other);
+
+		BigInt	operator+(const BigInt &rhs) const;
+		BigInt	operator-(const BigInt &rhs) const;
+		BigInt	operator*(const BigInt &rhs) const;
+		// false on division by zero
+		bool	divide(const BigInt &divisor, BigInt &quotient) const;
+
+		bool		isZero() const;
+		size_t		limbCount() const;
+		std::string	toString() const;
+
+	private:
+		typedef std::vector<unsigned int>	Limbs;
+
+		Limbs	_limbs;
+		bool	_negative;
+
+		void	normalise();
+
+		// Magnitude helpers
+		static int	compareMagnitude(const Limbs &a, const Limbs &b);
+		static void	addMagnitude(const Limbs &a, const Limbs &b, Limbs &out);
+		static void	subMagnitude(const Limbs &a, const Limbs &b, Limbs &out); // |a| >= |b|
+		static void	mulMagnitude(const Limbs &a, const Limbs &b, Limbs &out);
+		static void	mulSchoolbook(const Limbs &a, const Limbs &b, Limbs &out);
+		static void	mulKaratsuba(const Limbs &a, const Limbs &b, Limbs &out);
+		static void	addShifted(Limbs &acc, const Limbs &value, size_t shift);
+		static void	divideMagnitude(const Limbs &u, const Limbs &v, Limbs &quotient);
+		static unsigned int	divideSmall(Limbs &value, unsigned int divisor);
+		static void	trim(Limbs &limbs);
+};
+
+#endif
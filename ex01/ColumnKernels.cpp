@@ -0,0 +1,150 @@
+#include "ColumnKernels.hpp"
+#include <climits> // LONG_MIN
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+#endif
+
+// =============================================================================
+// Helper
+// =============================================================================
+
+/*
+	mask bit k set -> row first + k overflowed (keep an earlier error)
+*/
+void	ColumnKernels::flagRows(int mask, size_t first, unsigned char *status)
+{
+	size_t	lane = 0;
+	while (mask != 0)
+	{
+		if ((mask & 1) && status[first + lane] == ROW_OK)
+			status[first + lane] = ROW_OVERFLOW;
+		mask >>= 1;
+		lane++;
+	}
+}
+
+void	ColumnKernels::fill(long value, long *out, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		out[i] = value;
+}
+
+// =============================================================================
+// Add / Sub (vectorised)
+// =============================================================================
+
+void	ColumnKernels::add(const long *a, const long *b, long *out, unsigned char *status, size_t n)
+{
+	size_t	i = 0;
+#if defined(__AVX2__)
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i	va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+		__m256i	vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+		__m256i	r = _mm256_add_epi64(va, vb);
+		__m256i	overflow = _mm256_and_si256(_mm256_xor_si256(va, r), _mm256_xor_si256(vb, r));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+		int		mask = _mm256_movemask_pd(_mm256_castsi256_pd(overflow));
+		if (mask != 0)
+			flagRows(mask, i, status);
+	}
+#elif defined(__SSE2__)
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128i	va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		__m128i	vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		__m128i	r = _mm_add_epi64(va, vb);
+		__m128i	overflow = _mm_and_si128(_mm_xor_si128(va, r), _mm_xor_si128(vb, r));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+		int		mask = _mm_movemask_pd(_mm_castsi128_pd(overflow));
+		if (mask != 0)
+			flagRows(mask, i, status);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		long	r = static_cast<long>(static_cast<unsigned long>(a[i]) + static_cast<unsigned long>(b[i]));
+		if (((a[i] ^ r) & (b[i] ^ r)) < 0 && status[i] == ROW_OK)
+			status[i] = ROW_OVERFLOW;
+		out[i] = r;
+	}
+}
+
+void	ColumnKernels::sub(const long *a, const long *b, long *out, unsigned char *status, size_t n)
+{
+	size_t	i = 0;
+#if defined(__AVX2__)
+	for (; i + 4 <= n; i += 4)
+	{
+		__m256i	va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+		__m256i	vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+		__m256i	r = _mm256_sub_epi64(va, vb);
+		__m256i	overflow = _mm256_and_si256(_mm256_xor_si256(va, vb), _mm256_xor_si256(va, r));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), r);
+		int		mask = _mm256_movemask_pd(_mm256_castsi256_pd(overflow));
+		if (mask != 0)
+			flagRows(mask, i, status);
+	}
+#elif defined(__SSE2__)
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128i	va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		__m128i	vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		__m128i	r = _mm_sub_epi64(va, vb);
+		__m128i	overflow = _mm_and_si128(_mm_xor_si128(va, vb), _mm_xor_si128(va, r));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), r);
+		int		mask = _mm_movemask_pd(_mm_castsi128_pd(overflow));
+		if (mask != 0)
+			flagRows(mask, i, status);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		long	r = static_cast<long>(static_cast<unsigned long>(a[i]) - static_cast<unsigned long>(b[i]));
+		if (((a[i] ^ b[i]) & (a[i] ^ r)) < 0 && status[i] == ROW_OK)
+			status[i] = ROW_OVERFLOW;
+		out[i] = r;
+	}
+}
+
+// =============================================================================
+// Mul / Div (scalar per lane)
+// =============================================================================
+
+void	ColumnKernels::mul(const long *a, const long *b, long *out, unsigned char *status, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		long	r;
+		if (__builtin_mul_overflow(a[i], b[i], &r) && status[i] == ROW_OK)
+			status[i] = ROW_OVERFLOW;
+		out[i] = r;
+	}
+}
+
+/*
+	A failing lane divides by 1 instead, so nothing ever traps
+*/
+void	ColumnKernels::div(const long *a, const long *b, long *out, unsigned char *status, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+	{
+		long	divisor = b[i];
+		if (divisor == 0)
+		{
+			if (status[i] == ROW_OK)
+				status[i] = ROW_DIVISION_BY_ZERO;
+			divisor = 1;
+		}
+		else if (divisor == -1 && a[i] == LONG_MIN)
+		{
+			if (status[i] == ROW_OK)
+				status[i] = ROW_OVERFLOW;
+			divisor = 1;
+		}
+		out[i] = a[i] / divisor;
+	}
+}
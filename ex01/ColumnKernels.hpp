@@ -0,0 +1,48 @@
+#ifndef COLUMNKERNELS_HPP
+# define COLUMNKERNELS_HPP
+
+#include <cstddef>
+
+/*
+	Element-wise kernels for column evaluation (RPN::evaluateColumns).
+
+	out[i] = a[i] op b[i] for n rows, and status[i] records the first error
+	of each row, with the exact rules of RPN::safeAdd/safeSub/safeMul/safeDiv:
+	- add / sub : overflow when the signed result does not fit a long
+	- mul       : overflow when the product does not fit a long
+	- div       : division by zero, or LONG_MIN / -1 (overflow)
+	A row that already failed keeps its first status, its values are
+	meaningless from then on (they wrap, they never trap).
+
+	add / sub use SSE2 (2 lanes) or AVX2 (4 lanes) when the compiler
+	targets them: overflow is ((a ^ r) & (b ^ r)) < 0 for add and
+	((a ^ b) & (a ^ r)) < 0 for sub, computed for all lanes at once.
+	There is no 64 bit SIMD multiply/divide before AVX-512, so mul / div
+	stay scalar per lane.
+*/
+class	ColumnKernels
+{
+	public:
+		enum RowStatus
+		{
+			ROW_OK = 0,
+			ROW_OVERFLOW,
+			ROW_DIVISION_BY_ZERO
+		};
+
+		static void	add(const long *a, const long *b, long *out, unsigned char *status, size_t n);
+		static void	sub(const long *a, const long *b, long *out, unsigned char *status, size_t n);
+		static void	mul(const long *a, const long *b, long *out, unsigned char *status, size_t n);
+		static void	div(const long *a, const long *b, long *out, unsigned char *status, size_t n);
+		static void	fill(long value, long *out, size_t n);
+
+	private:
+		ColumnKernels();
+		~ColumnKernels();
+		ColumnKernels(const ColumnKernels &other);
+		ColumnKernels	&operator=(const ColumnKernels &other);
+
+		static void	flagRows(int mask, size_t first, unsigned char *status);
+};
+
+#endif
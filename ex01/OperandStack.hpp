@@ -0,0 +1,127 @@
+#ifndef OPERANDSTACK_HPP
+# define OPERANDSTACK_HPP
+
+#include <cstddef>
+
+/*
+	Contiguous LIFO stack with small inline storage.
+
+	std::stack<long, std::list<long> > allocates a node on every push and
+	frees it on every pop. Here:
+	- the first InlineCapacity values live inside the object (no heap at all)
+	- past that, one heap buffer doubles when full and is never shrunk,
+	  so a reused stack stops allocating once it has seen its peak depth
+
+	Same calls as std::stack: push / pop / top / size / empty
+*/
+template <typename T, size_t InlineCapacity>
+class	OperandStack
+{
+	public:
+		OperandStack():
+			_data(_inline),
+			_size(0),
+			_capacity(InlineCapacity)
+		{}
+
+		~OperandStack()
+		{
+			if (_data != _inline)
+				delete[] _data;
+		}
+
+		OperandStack(const OperandStack &other):
+			_data(_inline),
+			_size(0),
+			_capacity(InlineCapacity)
+		{
+			copyFrom(other);
+		}
+
+		OperandStack	&operator=(const OperandStack &other)
+		{
+			if (this != &other)
+				copyFrom(other);
+			return (*this);
+		}
+
+		void	push(const T &value)
+		{
+			if (_size == _capacity)
+				grow(_capacity * 2);
+			_data[_size] = value;
+			_size++;
+		}
+
+		void	pop()
+		{
+			_size--;
+		}
+
+		T	&top()
+		{
+			return (_data[_size - 1]);
+		}
+
+		const T	&top() const
+		{
+			return (_data[_size - 1]);
+		}
+
+		size_t	size() const
+		{
+			return (_size);
+		}
+
+		bool	empty() const
+		{
+			return (_size == 0);
+		}
+
+		// Keep the buffer, only forget the values
+		void	clear()
+		{
+			_size = 0;
+		}
+
+		// Make room for `capacity` values up front
+		void	reserve(size_t capacity)
+		{
+			if (capacity > _capacity)
+				grow(capacity);
+		}
+
+		// Raw storage, for loops that verified their depth and fit in reserve()
+		T	*data()
+		{
+			return (_data);
+		}
+
+	private:
+		T		_inline[InlineCapacity];
+		T		*_data;
+		size_t	_size;
+		size_t	_capacity;
+
+		void	grow(size_t capacity)
+		{
+			T	*bigger = new T[capacity];
+			for (size_t i = 0; i < _size; i++)
+				bigger[i] = _data[i];
+			if (_data != _inline)
+				delete[] _data;
+			_data = bigger;
+			_capacity = capacity;
+		}
+
+		void	copyFrom(const OperandStack &other)
+		{
+			_size = 0;
+			reserve(other._size);
+			for (size_t i = 0; i < other._size; i++)
+				_data[i] = other._data[i];
+			_size = other._size;
+		}
+};
+
+#endif
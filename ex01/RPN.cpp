@@ -1,4 +1,10 @@
 #include "RPN.hpp"
+#include "RPNIncremental.hpp"
+#include <algorithm> // std::copy
+#include <unistd.h> // read
+#include <cerrno>
+
+#define STREAM_BUFFER_SIZE 65536
 
 // =============================================================================
 // Ctors & Dtors & Copy Assignment Operator
@@ -11,13 +17,19 @@ RPN::~RPN()
 {}
 
 RPN::RPN(const RPN &other):
-	_stack(other._stack)
+	_stack(other._stack),
+	_temps(other._temps),
+	_profile(other._profile)
 {}
 
 RPN	&RPN::operator=(const RPN &other)
 {
 	if (this != &other)
+	{
 		this->_stack = other._stack;
+		this->_temps = other._temps;
+		this->_profile = other._profile;
+	}
 	return (*this);
 }
 
@@ -28,31 +40,36 @@ RPN	&RPN::operator=(const RPN &other)
 bool	RPN::calculateExpression(const std::string &expression, long &output)
 {
 	cleanStack();
+#ifdef RPN_PROFILE
+	_profile.recordExpression();
+#endif
 
-	std::istringstream	istream(expression);
+	RPNTokenizer	tokenizer(expression.data(), expression.size());
 	while (true)
 	{
-		Token	token;
-		bool	readSuccess = readNextToken(istream, token);
-		if (readSuccess == false) // stream errors
-			return (false);
-		if (token.type == TOKEN_END)
+		RPNTokenizer::Token	token;
+		tokenizer.next(token);
+		if (token.kind == RPNTokenizer::TOKEN_END)
 			break;
-		classifyToken(token);
-		if (token.type == TOKEN_NUMBER)
+		if (token.kind == RPNTokenizer::TOKEN_NUMBER)
 		{
 			bool	numSuccess = handleNumberToken(token);
 			if (numSuccess == false)
 				return (false);
 		}
-		else if (token.type == TOKEN_OPERATOR)
+		else if (token.kind == RPNTokenizer::TOKEN_OPERATOR)
 		{
 			bool	opSuccess = handleOperatorToken(token);
 			if (opSuccess == false)
 				return (false);
 		}
 		else // invalid token
+		{
+#ifdef RPN_PROFILE
+			_profile.recordReject(RPNProfile::REJECT_INVALID_TOKEN);
+#endif
 			return (false);
+		}
 	}
 	bool	finish = finalizeResults(output);
 	if (finish == false)
@@ -61,134 +78,364 @@ bool	RPN::calculateExpression(const std::string &expression, long &output)
 }
 
 // =============================================================================
-// Tokenisation Helper
+// Compiled Program
 // =============================================================================
 
-bool	RPN::readNextToken(std::istringstream &istream, Token &outToken) const
+/*
+	Tokenise and validate once, emit one instruction per token.
+	"3 4 +" -> PUSH 3, PUSH 4, ADD
+
+	Only the tokens are validated here, stack depth and arithmetic
+	errors are still detected by evaluate() like calculateExpression.
+	Unlike calculateExpression, variables (a..z) are accepted.
+*/
+bool	RPN::compile(const std::string &expression, RPNProgram &program) const
 {
-	outToken.text.clear();
-	outToken.type = TOKEN_INVALID; // set to default
+	program.clear();
 
-	if (istream >> outToken.text)
-		return (true);
-	else
+	RPNTokenizer	tokenizer(expression.data(), expression.size());
+	while (true)
 	{
-		// Reached EOF, mark it as end-of-input
-		if (istream.eof())
+		RPNTokenizer::Token	token;
+		tokenizer.next(token);
+		if (token.kind == RPNTokenizer::TOKEN_END)
+			break;
+		if (token.kind == RPNTokenizer::TOKEN_NUMBER)
+			program.emit(RPNProgram::OP_PUSH, token.value);
+		else if (token.kind == RPNTokenizer::TOKEN_VARIABLE)
+			program.emit(RPNProgram::OP_LOAD, token.value);
+		else if (token.kind == RPNTokenizer::TOKEN_OPERATOR)
 		{
-			outToken.type = TOKEN_END;
-			return (true);
+			if (token.value == '+')
+				program.emit(RPNProgram::OP_ADD, 0);
+			else if (token.value == '-')
+				program.emit(RPNProgram::OP_SUB, 0);
+			else if (token.value == '*')
+				program.emit(RPNProgram::OP_MUL, 0);
+			else
+				program.emit(RPNProgram::OP_DIV, 0);
 		}
-		else
-			return (false); // Other stream error (badbit/failbit) which is not eof
+		else // invalid token
+			return (false);
 	}
+	return (true);
 }
 
-void	RPN::classifyToken(Token &token) const
+/*
+	Run a compiled program: no tokenisation, no string handling.
+	Same results and errors as calculateExpression on the source text.
+	A program using variables needs evaluate(program, variables, output).
+*/
+bool	RPN::evaluate(const RPNProgram &program, long &output)
 {
-	// We only accept single token as stated in subject
-	if (token.text.size() == 1)
+	return (evaluate(program, 0, output));
+}
+
+bool	RPN::evaluate(const RPNProgram &program, const long *variables, long &output)
+{
+	return (evaluateWith<CheckedArithmetic>(program, variables, output));
+}
+
+// One dispatch per call, each mode runs its own instantiation of the loop
+bool	RPN::evaluate(const RPNProgram &program, const long *variables, long &output,
+						ArithmeticMode mode)
+{
+	switch (mode)
 	{
-		unsigned char character = static_cast<unsigned char>(token.text[0]);
-		if (std::isdigit(character))
-		{
-			token.type = TOKEN_NUMBER;
-			return ;
-		}
-		if (isOperatorChar(token.text[0]))
+		case MODE_CHECKED:
+			return (evaluateWith<CheckedArithmetic>(program, variables, output));
+		case MODE_WRAPPING:
+			return (evaluateWith<WrappingArithmetic>(program, variables, output));
+		case MODE_SATURATING:
+			return (evaluateWith<SaturatingArithmetic>(program, variables, output));
+		case MODE_MODULAR:
+			return (evaluateWith<ModularArithmetic>(program, variables, output));
+	}
+	return (false);
+}
+
+bool	RPN::parseArithmeticMode(const std::string &name, ArithmeticMode &mode)
+{
+	if (name == "checked")
+		mode = MODE_CHECKED;
+	else if (name == "wrap")
+		mode = MODE_WRAPPING;
+	else if (name == "saturate")
+		mode = MODE_SATURATING;
+	else if (name == "mod")
+		mode = MODE_MODULAR;
+	else
+		return (false);
+	return (true);
+}
+
+// =============================================================================
+// Column Evaluation
+// =============================================================================
+
+#define COLUMN_BLOCK 1024 // rows per block: the stack of columns stays in cache
+
+/*
+	Column-at-a-time: each instruction runs over a block of rows before
+	the next one, so the dispatch cost is paid once per block, not per row.
+
+	"x 2 * y +" on rows 0..1023:
+		slot0 = x          (points into the input column, no copy)
+		slot1 = 2 2 2 ...  (filled)
+		slot0 = slot0 * slot1  -> ColumnKernels::mul
+		slot1 = y
+		slot0 = slot0 + slot1  -> ColumnKernels::add
+
+	Every row gets the status the scalar evaluate() would give it:
+	operations run in program order, so the first error of a row is kept.
+
+	A slot may point below itself (DUP / OVER share the rows): that block
+	is only overwritten once the slot is popped. SWAP would point a slot
+	above itself, so it copies the rows instead (spare block as scratch).
+*/
+bool	RPN::evaluateColumns(const RPNProgram &program,
+							const long *const *columns,
+							size_t rows,
+							long *results,
+							unsigned char *status) const
+{
+	size_t	maxDepth = 0;
+	if (program.measureDepth(maxDepth) == false)
+		return (false);
+	if (program.variableCount() > 0 && columns == 0)
+		return (false);
+
+	std::vector<long>			scratch((maxDepth + 1) * COLUMN_BLOCK);
+	std::vector<long>			temps(program.tempCount() * COLUMN_BLOCK);
+	std::vector<const long *>	slots(maxDepth);
+	for (size_t row = 0; row < rows; row++)
+		status[row] = ColumnKernels::ROW_OK;
+
+	for (size_t start = 0; start < rows; start += COLUMN_BLOCK)
+	{
+		size_t	n = rows - start;
+		if (n > COLUMN_BLOCK)
+			n = COLUMN_BLOCK;
+		size_t	depth = 0;
+		for (size_t i = 0; i < program.size(); i++)
 		{
-			token.type = TOKEN_OPERATOR;
-			return ;
+			const RPNProgram::Instruction	&instruction = program[i];
+			if (instruction.opcode == RPNProgram::OP_PUSH)
+			{
+				long	*slot = &scratch[depth * COLUMN_BLOCK];
+				ColumnKernels::fill(instruction.operand, slot, n);
+				slots[depth++] = slot;
+				continue;
+			}
+			if (instruction.opcode == RPNProgram::OP_LOAD)
+			{
+				slots[depth++] = columns[instruction.operand] + start;
+				continue;
+			}
+			if (instruction.opcode == RPNProgram::OP_SAVE)
+			{
+				// copy: the slot itself is overwritten by later operations
+				long	*temp = &temps[instruction.operand * COLUMN_BLOCK];
+				for (size_t row = 0; row < n; row++)
+					temp[row] = slots[depth - 1][row];
+				continue;
+			}
+			if (instruction.opcode == RPNProgram::OP_RECALL)
+			{
+				slots[depth++] = &temps[instruction.operand * COLUMN_BLOCK];
+				continue;
+			}
+			if (instruction.opcode == RPNProgram::OP_DUP || instruction.opcode == RPNProgram::OP_OVER)
+			{
+				slots[depth] = slots[depth - ((instruction.opcode == RPNProgram::OP_DUP) ? 1 : 2)];
+				depth++;
+				continue;
+			}
+			if (instruction.opcode == RPNProgram::OP_SWAP)
+			{
+				long	*spare = &scratch[maxDepth * COLUMN_BLOCK];
+				long	*low = &scratch[(depth - 2) * COLUMN_BLOCK];
+				long	*high = &scratch[(depth - 1) * COLUMN_BLOCK];
+				std::copy(slots[depth - 2], slots[depth - 2] + n, spare);
+				if (slots[depth - 1] != low) // DUP of the slot below: already there
+					std::copy(slots[depth - 1], slots[depth - 1] + n, low);
+				std::copy(spare, spare + n, high);
+				slots[depth - 2] = low;
+				slots[depth - 1] = high;
+				continue;
+			}
+			if (instruction.opcode == RPNProgram::OP_DROP)
+			{
+				depth--;
+				continue;
+			}
+			long			*out = &scratch[(depth - 2) * COLUMN_BLOCK];
+			const long		*lhs = slots[depth - 2];
+			const long		*rhs = slots[depth - 1];
+			unsigned char	*rowStatus = status + start;
+			if (instruction.opcode == RPNProgram::OP_ADD)
+				ColumnKernels::add(lhs, rhs, out, rowStatus, n);
+			else if (instruction.opcode == RPNProgram::OP_SUB)
+				ColumnKernels::sub(lhs, rhs, out, rowStatus, n);
+			else if (instruction.opcode == RPNProgram::OP_MUL)
+				ColumnKernels::mul(lhs, rhs, out, rowStatus, n);
+			else
+				ColumnKernels::div(lhs, rhs, out, rowStatus, n);
+			slots[depth - 2] = out;
+			depth--;
 		}
+		for (size_t row = 0; row < n; row++)
+			results[start + row] = slots[0][row];
 	}
+	return (true);
 }
 
-bool	RPN::isOperatorChar(char c) const
+// =============================================================================
+// Streaming Evaluation
+// =============================================================================
+
+/*
+	Same grammar and results as calculateExpression, but the expression
+	never has to be in memory: it is read from fd in STREAM_BUFFER_SIZE
+	blocks and fed to an RPNIncremental as it arrives, which only keeps
+	the stack and the last token byte between blocks.
+	The first error stops the evaluation without reading the rest.
+*/
+bool	RPN::calculateStream(int fd, long &output, size_t &bytesRead)
 {
-	switch (c)
+	bytesRead = 0;
+
+	RPNIncremental	incremental;
+	char			buffer[STREAM_BUFFER_SIZE];
+	while (true)
 	{
-		case '+':
-			return (true);
-		case '-':
-			return (true);
-		case '*':
-			return (true);
-		case '/':
-			return (true);
-		default:
+		ssize_t	count = read(fd, buffer, sizeof(buffer));
+		if (count < 0 && errno == EINTR)
+			continue;
+		if (count < 0)
 			return (false);
+		if (count == 0)
+			break;
+		bytesRead += static_cast<size_t>(count);
+		if (incremental.feed(buffer, static_cast<size_t>(count)) == false)
+			break; // finish() fails too
 	}
+	bool	success = incremental.finish(output);
+#ifdef RPN_PROFILE
+	_profile.merge(incremental.profile());
+#endif
+	return (success);
 }
 
-bool	RPN::isSingleDigitNumber(const std::string &str) const
+// =============================================================================
+// Big Integer Mode
+// =============================================================================
+
+/*
+	Same grammar and stack rules as calculateExpression, but operands are
+	BigInt: "9 9 * 9 * ... *" never overflows.
+	Division truncates toward zero and still fails on zero.
+*/
+bool	RPN::calculateExpressionBig(const std::string &expression, BigInt &output) const
 {
-	if (str.size() != 1)
-		return (false);
-	
-	unsigned char	character = static_cast<unsigned char>(str[0]);
-	if (std::isdigit(character))
-		return (true);
-	else
+	std::vector<BigInt>	stack;
+
+	RPNTokenizer	tokenizer(expression.data(), expression.size());
+	while (true)
+	{
+		RPNTokenizer::Token	token;
+		tokenizer.next(token);
+		if (token.kind == RPNTokenizer::TOKEN_END)
+			break;
+		if (token.kind == RPNTokenizer::TOKEN_NUMBER)
+		{
+			stack.push_back(BigInt(token.value));
+			continue;
+		}
+		if (token.kind != RPNTokenizer::TOKEN_OPERATOR || stack.size() < 2)
+			return (false);
+		BigInt	&lhs = stack[stack.size() - 2];
+		BigInt	&rhs = stack[stack.size() - 1];
+		if (token.value == '+')
+			lhs = lhs + rhs;
+		else if (token.value == '-')
+			lhs = lhs - rhs;
+		else if (token.value == '*')
+			lhs = lhs * rhs;
+		else if (lhs.divide(rhs, lhs) == false)
+			return (false);
+		stack.pop_back();
+	}
+	if (stack.size() != 1)
 		return (false);
+	output = stack[0];
+	return (true);
 }
 
 // =============================================================================
-// Evaluation Helper
+// Profiling
 // =============================================================================
-void	RPN::cleanStack()
+
+const RPNProfile	&RPN::profile() const
 {
-	while (!_stack.empty())
-		_stack.pop();
+	return (_profile);
 }
 
-bool	RPN::handleNumberToken(const Token &token)
+void	RPN::resetProfile()
 {
-	bool	success = isSingleDigitNumber(token.text);
-	if (success == false)
-		return (false);
-	unsigned char character = static_cast<unsigned char>(token.text[0]);
-	long	number = static_cast<long>(character - '0');
-	_stack.push(number);
-	return (true);
+	_profile.reset();
 }
 
-bool	RPN::handleOperatorToken(const Token &token)
+// =============================================================================
+// Evaluation Helper
+// =============================================================================
+void	RPN::cleanStack()
 {
-	// We needs two operands
-	if (_stack.size() < 2)
-		return (false);
-	
-	long	rhs = 0;
-	long	lhs = 0;
+	_stack.clear();
+}
 
-	bool	popSuccess = popTwoOperands(lhs, rhs);
-	if (popSuccess == false)
-		return (false);
-	long	results = 0;
-	bool	applySuccess = applyOperator(lhs, rhs, token.text[0], results);
-	if (applySuccess == false)
+bool	RPN::handleNumberToken(const RPNTokenizer::Token &token)
+{
+	if (token.kind != RPNTokenizer::TOKEN_NUMBER)
 		return (false);
-	_stack.push(results); // add the results back to the stack
+	_stack.push(token.value);
+#ifdef RPN_PROFILE
+	_profile.recordDepth(_stack.size());
+#endif
 	return (true);
 }
 
 /*
 	_stack.top() access the "last added element"
-	pop the first LAST element and put at right side 
-	pop the second LAST element and put at left side
+	pop the first LAST element and put at right side
+	the second LAST element is the left side, replaced by the result
 
 	9 1 /
 	9 / 1
+
+	One depth check per operator, the operation works in place on the top.
 */
-bool	RPN::popTwoOperands(long &lhs, long &rhs)
+bool	RPN::handleOperatorToken(const RPNTokenizer::Token &token)
 {
+	// We needs two operands
 	if (_stack.size() < 2)
+	{
+#ifdef RPN_PROFILE
+		_profile.recordReject(RPNProfile::REJECT_UNDERFLOW);
+#endif
 		return (false);
-	rhs = _stack.top();
-	_stack.pop();
-	lhs = _stack.top();
+	}
+	long	rhs = _stack.top();
 	_stack.pop();
-	return (true);
+	long	&lhs = _stack.top();
+#ifdef RPN_PROFILE
+	unsigned long long	start = RPNProfile::now();
+	bool				ok = applyOperator(lhs, rhs, static_cast<char>(token.value), lhs);
+	_profile.recordOperation(static_cast<char>(token.value), rhs, ok, start);
+	return (ok);
+#else
+	return (applyOperator(lhs, rhs, static_cast<char>(token.value), lhs));
+#endif
 }
 
 bool	RPN::applyOperator(long lhs, long rhs, char op, long &results) const
@@ -225,10 +472,32 @@ bool	RPN::applyOperator(long lhs, long rhs, char op, long &results) const
 		return (false);
 }
 
+bool	RPN::applyOpCode(long lhs, long rhs, RPNProgram::OpCode opcode, long &results) const
+{
+	switch (opcode)
+	{
+		case RPNProgram::OP_ADD:
+			return (safeAdd(lhs, rhs, results));
+		case RPNProgram::OP_SUB:
+			return (safeSub(lhs, rhs, results));
+		case RPNProgram::OP_MUL:
+			return (safeMul(lhs, rhs, results));
+		case RPNProgram::OP_DIV:
+			return (safeDiv(lhs, rhs, results));
+		default:
+			return (false);
+	}
+}
+
 bool	RPN::finalizeResults(long &finalOutput)
 {
 	if (_stack.size() != 1)
+	{
+#ifdef RPN_PROFILE
+		_profile.recordReject(RPNProfile::REJECT_LEFTOVER);
+#endif
 		return (false);
+	}
 	finalOutput = _stack.top();
 	cleanStack();
 	return (true);
@@ -238,76 +507,21 @@ bool	RPN::finalizeResults(long &finalOutput)
 // Safe Arithmetic
 // =============================================================================
 
+// The checks themselves live in CheckedArithmetic (Arithmetic.hpp)
+
 bool RPN::safeAdd(long a, long b, long &out) const
 {
-	if (b > 0)
-	{
-		if (a > LONG_MAX - b)
-			return (false);
-	}
-	else if (b < 0)
-	{
-		if (a < LONG_MIN - b)
-			return (false);
-	}
-	out = a + b;
-	return (true);
+	return (CheckedArithmetic::add(a, b, out));
 }
 
 bool RPN::safeSub(long a, long b, long &out) const
 {
-	if (b > 0)
-	{
-		if (a < LONG_MIN + b)
-			return (false);
-	}
-	else if (b < 0)
-	{
-		if (a > LONG_MAX + (-b))
-			return (false);
-	}
-	out = a - b;
-	return (true);
+	return (CheckedArithmetic::sub(a, b, out));
 }
 
 bool RPN::safeMul(long a, long b, long &out) const
 {
-	if (a == 0 || b == 0)
-	{
-		out = 0;
-		return true;
-	}
-	// We need to ensure |a * b| <= LONG_MAX and respects LONG_MIN.
-	if (a > 0)
-	{
-		if (b > 0)
-		{
-			if (a > LONG_MAX / b)
-				return (false);
-		}
-		else // b < 0
-		{
-			// product negative, check against LONG_MIN
-			if (b < LONG_MIN / a)
-				return (false);
-		}
-	}
-	else // a < 0
-	{
-		if (b > 0)
-		{
-			// product negative, check against LONG_MIN
-			if (a < LONG_MIN / b)
-				return (false);
-		}
-		else // b < 0, product positive
-		{
-			if (a < LONG_MAX / b)
-				return (false); // Example: a = -X, b = -Y; if a < LONG_MAX / b, overflow
-		}
-	}
-	out = a * b;
-	return (true);
+	return (CheckedArithmetic::mul(a, b, out));
 }
 
 /*
@@ -333,11 +547,5 @@ bool RPN::safeMul(long a, long b, long &out) const
 */
 bool RPN::safeDiv(long a, long b, long &out) const
 {
-	if (b == 0)
-		return (false);
-	// Special overflow: LONG_MIN / -1 overflows on 2’s complement
-	if (a == LONG_MIN && b == -1)
-		return (false);
-	out = a / b;
-	return (true);
+	return (CheckedArithmetic::div(a, b, out));
 }
@@ -3,11 +3,16 @@
 
 #include <iostream>
 #include <string>
-#include <stack>
-#include <list>
-#include <sstream>
 #include <climits>  // LONG_MAX, LONG_MIN
 #include <cctype> // std::isdigit
+#include "RPNProgram.hpp"
+#include "RPNTokenizer.hpp"
+#include "OperandStack.hpp"
+#include "BigInt.hpp"
+#include "ColumnKernels.hpp"
+#include "Arithmetic.hpp"
+#include "RPNProfile.hpp"
+#include <vector>
 
 /*
 	Infix (usual mathematical operation) : 3 + 4 * 2
@@ -32,49 +37,73 @@
 		- → pop 3,17 → 17-3=14 → 14
 	
 	RPN is LIFO, so use stack container(LIFO)
-	Shunting-Yard algorithm converts infix → postfix (RPN)
+	The stack is contiguous with inline storage (OperandStack): no allocation per push
+	Shunting-Yard algorithm converts infix → postfix (RPN): RPNInfix, straight into an RPNProgram
 */
 
 class	RPN
 {
 	public:
+		// Arithmetic.hpp policies, for the flag-selected evaluate()
+		enum ArithmeticMode
+		{
+			MODE_CHECKED,	// subject rules (default)
+			MODE_WRAPPING,
+			MODE_SATURATING,
+			MODE_MODULAR	// mod 1000000007
+		};
+
 		RPN();
 		~RPN();
 		RPN(const RPN &other);
 		RPN	&operator=(const RPN &other);
 
-		// Token
-		enum TokenType
-		{
-			TOKEN_NUMBER,
-			TOKEN_OPERATOR,
-			TOKEN_INVALID,
-			TOKEN_END
-		};
-
-		struct Token
-		{
-			std::string	text;
-			TokenType	type;
-		};
-
 		// API
 		bool	calculateExpression(const std::string &expression, long &output);
 
-	private:
-		std::stack<long, std::list<long> > _stack; // C++98 require a space
+		// Compiled API : parse once, evaluate many times
+		bool	compile(const std::string &expression, RPNProgram &program) const;
+		bool	evaluate(const RPNProgram &program, long &output);
+		bool	evaluate(const RPNProgram &program, const long *variables, long &output);
+		bool	evaluate(const RPNProgram &program, const long *variables, long &output,
+							ArithmeticMode mode);
+		static bool	parseArithmeticMode(const std::string &name, ArithmeticMode &mode);
+
+		// Policy chosen at compile time: evaluateWith<WrappingArithmetic>(...)
+		// RPNOptimizer folds with the checked rules, optimise for MODE_CHECKED only
+		template <typename Arithmetic>
+		bool	evaluateWith(const RPNProgram &program, const long *variables, long &output);
+
+		// Column API : one program over whole columns (columns[0] is 'a', ...)
+		// status[row] is a ColumnKernels::RowStatus, false = malformed program
+		bool	evaluateColumns(const RPNProgram &program,
+								const long *const *columns,
+								size_t rows,
+								long *results,
+								unsigned char *status) const;
+
+		// Streaming mode : reads fd to EOF in fixed buffers, memory = buffer + stack
+		bool	calculateStream(int fd, long &output, size_t &bytesRead);
 
-		// Tokenization Helper
-		bool	readNextToken(std::istringstream &istream, Token &outToken) const;
-		void	classifyToken(Token &token) const;
-		bool	isOperatorChar(char c) const;
-		bool	isSingleDigitNumber(const std::string &str) const;
+		// Big integer mode : no overflow, only division by zero fails
+		bool	calculateExpressionBig(const std::string &expression, BigInt &output) const;
+
+		// One checked operation, exactly as evaluate() runs it (constant folding)
+		bool	applyOpCode(long lhs, long rhs, RPNProgram::OpCode opcode, long &results) const;
+
+		// Profiling : counters since the last reset, recorded by a -DRPN_PROFILE build only
+		const RPNProfile	&profile() const;
+		void				resetProfile();
+
+	private:
+		OperandStack<long, 32>	_stack; // 32 operands inline, grows on the heap past that
+		std::vector<long>		_temps; // SAVE / RECALL slots of optimised programs
+		RPNProfile				_profile;
 
 		// Evaluation Helper
 		void	cleanStack();
-		bool	handleNumberToken(const Token &token);
-		bool	handleOperatorToken(const Token &token);
-		bool	popTwoOperands(long &lhs, long &rhs);
+		bool	handleNumberToken(const RPNTokenizer::Token &token);
+		bool	handleOperatorToken(const RPNTokenizer::Token &token);
 		bool	applyOperator(long lhs, long rhs, char op, long &results) const;
 		bool	finalizeResults(long &finalOutput);
 
@@ -87,4 +116,113 @@ class	RPN
 
 };
 
+// Template
+
+/*
+	The evaluation loop, instantiated once per policy: the arithmetic is
+	inlined, a policy that is never used is never compiled in.
+	The program's stack effect is already verified (RPNProgram::measureDepth,
+	kept while it was built), so the loop runs on a stack reserved to the
+	peak depth without any depth check. Operators work in place on the top.
+*/
+template <typename Arithmetic>
+bool	RPN::evaluateWith(const RPNProgram &program, const long *variables, long &output)
+{
+	cleanStack();
+#ifdef RPN_PROFILE
+	_profile.recordExpression();
+#endif
+	size_t	maxDepth = 0;
+	if (program.measureDepth(maxDepth) == false)
+	{
+#ifdef RPN_PROFILE
+		_profile.recordReject(program.underflows() ? RPNProfile::REJECT_UNDERFLOW
+			: RPNProfile::REJECT_LEFTOVER);
+#endif
+		return (false);
+	}
+	if (program.variableCount() > 0 && variables == 0)
+		return (false);
+	if (_temps.size() < program.tempCount())
+		_temps.resize(program.tempCount());
+	_stack.reserve(maxDepth);
+#ifdef RPN_PROFILE
+	_profile.recordDepth(maxDepth);
+#endif
+
+	// verified program: no depth check below, only the arithmetic can fail
+	long	*stack = _stack.data();
+	size_t	depth = 0;
+	size_t	count = program.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		const RPNProgram::Instruction	&instruction = program[i];
+		switch (instruction.opcode)
+		{
+			case RPNProgram::OP_PUSH:
+				stack[depth++] = Arithmetic::fromLong(instruction.operand);
+				continue;
+			case RPNProgram::OP_LOAD:
+				stack[depth++] = Arithmetic::fromLong(variables[instruction.operand]);
+				continue;
+			case RPNProgram::OP_SAVE:
+				_temps[instruction.operand] = stack[depth - 1];
+				continue;
+			case RPNProgram::OP_RECALL:
+				stack[depth++] = _temps[instruction.operand];
+				continue;
+			case RPNProgram::OP_DUP:
+				stack[depth] = stack[depth - 1];
+				depth++;
+				continue;
+			case RPNProgram::OP_SWAP:
+			{
+				long	top = stack[depth - 1];
+				stack[depth - 1] = stack[depth - 2];
+				stack[depth - 2] = top;
+				continue;
+			}
+			case RPNProgram::OP_OVER:
+				stack[depth] = stack[depth - 2];
+				depth++;
+				continue;
+			case RPNProgram::OP_DROP:
+				depth--;
+				continue;
+			default:
+				break;
+		}
+		long	rhs = stack[--depth];
+		long	&lhs = stack[depth - 1];
+		bool	ok = false;
+#ifdef RPN_PROFILE
+		unsigned long long	start = RPNProfile::now();
+#endif
+		switch (instruction.opcode)
+		{
+			case RPNProgram::OP_ADD:
+				ok = Arithmetic::add(lhs, rhs, lhs);
+				break;
+			case RPNProgram::OP_SUB:
+				ok = Arithmetic::sub(lhs, rhs, lhs);
+				break;
+			case RPNProgram::OP_MUL:
+				ok = Arithmetic::mul(lhs, rhs, lhs);
+				break;
+			case RPNProgram::OP_DIV:
+				ok = Arithmetic::div(lhs, rhs, lhs);
+				break;
+			default:
+				break;
+		}
+#ifdef RPN_PROFILE
+		_profile.recordOperation(instruction.opcode, rhs, ok, start);
+#endif
+		if (ok == false)
+			return (false);
+	}
+	output = Arithmetic::toLong(stack[0]);
+	return (true);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "RPNBatch.hpp"
+#include <unistd.h> // sysconf
+
+#define BATCH_BLOCK_LINES 65536
+#define BATCH_SLICE_LINES 256
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+/*
+	Default: one worker per online core
+*/
+RPNBatch::RPNBatch():
+	_workerCount(1),
+	_lines(),
+	_results(),
+	_success(),
+	_nextSlice(0)
+{
+	long	cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores > 1)
+		_workerCount = static_cast<size_t>(cores);
+	pthread_mutex_init(&_sliceMutex, 0);
+}
+
+RPNBatch::RPNBatch(size_t workers):
+	_workerCount(workers == 0 ? 1 : workers),
+	_lines(),
+	_results(),
+	_success(),
+	_nextSlice(0)
+{
+	pthread_mutex_init(&_sliceMutex, 0);
+}
+
+RPNBatch::~RPNBatch()
+{
+	pthread_mutex_destroy(&_sliceMutex);
+}
+
+// The mutex is never copied, each batch owns its own
+RPNBatch::RPNBatch(const RPNBatch &other):
+	_workerCount(other._workerCount),
+	_lines(),
+	_results(),
+	_success(),
+	_nextSlice(0)
+{
+	pthread_mutex_init(&_sliceMutex, 0);
+}
+
+RPNBatch	&RPNBatch::operator=(const RPNBatch &other)
+{
+	if (this != &other)
+		this->_workerCount = other._workerCount;
+	return (*this);
+}
+
+// =============================================================================
+// Batch
+// =============================================================================
+
+size_t	RPNBatch::run(std::istream &input, std::ostream &output)
+{
+	std::vector<Worker>	workers(_workerCount);
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].batch = this;
+
+	size_t		errors = 0;
+	std::string	line;
+	_lines.clear();
+	while (std::getline(input, line))
+	{
+		_lines.push_back(line);
+		if (_lines.size() == BATCH_BLOCK_LINES)
+		{
+			evaluateBlock(workers);
+			errors += writeBlock(output);
+			_lines.clear();
+		}
+	}
+	if (!_lines.empty())
+	{
+		evaluateBlock(workers);
+		errors += writeBlock(output);
+		_lines.clear();
+	}
+	return (errors);
+}
+
+/*
+	Workers pull slices until the block is exhausted.
+	If a thread cannot be started, the calling thread does its share.
+*/
+void	RPNBatch::evaluateBlock(std::vector<Worker> &workers)
+{
+	_results.assign(_lines.size(), 0);
+	_success.assign(_lines.size(), 0);
+	_nextSlice = 0;
+
+	std::vector<pthread_t>	threads(workers.size());
+	std::vector<bool>		started(workers.size(), false);
+	for (size_t i = 1; i < workers.size(); i++)
+	{
+		if (pthread_create(&threads[i], 0, &workerRoutine, &workers[i]) == 0)
+			started[i] = true;
+	}
+	workerRoutine(&workers[0]);
+	for (size_t i = 1; i < workers.size(); i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], 0);
+	}
+}
+
+void	*RPNBatch::workerRoutine(void *arg)
+{
+	Worker		*worker = static_cast<Worker *>(arg);
+	RPNBatch	*batch = worker->batch;
+	size_t		begin = 0;
+	size_t		end = 0;
+
+	while (batch->claimSlice(begin, end))
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			long	value = 0;
+			if (worker->rpn.calculateExpression(batch->_lines[i], value))
+			{
+				batch->_results[i] = value;
+				batch->_success[i] = 1;
+			}
+		}
+	}
+	return (0);
+}
+
+bool	RPNBatch::claimSlice(size_t &begin, size_t &end)
+{
+	pthread_mutex_lock(&_sliceMutex);
+	begin = _nextSlice;
+	_nextSlice += BATCH_SLICE_LINES;
+	pthread_mutex_unlock(&_sliceMutex);
+	if (begin >= _lines.size())
+		return (false);
+	end = begin + BATCH_SLICE_LINES;
+	if (end > _lines.size())
+		end = _lines.size();
+	return (true);
+}
+
+/*
+	"Error" goes to the same stream as the values, otherwise the input
+	order would be lost between stdout and stderr
+*/
+size_t	RPNBatch::writeBlock(std::ostream &output) const
+{
+	size_t	errors = 0;
+	for (size_t i = 0; i < _lines.size(); i++)
+	{
+		if (_success[i])
+			output << _results[i] << '\n';
+		else
+		{
+			output << "Error\n";
+			errors++;
+		}
+	}
+	output.flush();
+	return (errors);
+}
@@ -0,0 +1,51 @@
+#ifndef RPNBATCH_HPP
+# define RPNBATCH_HPP
+
+#include "RPN.hpp"
+#include <vector>
+#include <pthread.h>
+
+/*
+	Batch mode: one expression per line, many expressions per process.
+
+	Lines are read by blocks, each block is cut into small slices that the
+	worker threads claim one after the other (each worker owns its RPN).
+	Once a block is done, results are written in input order:
+		"<value>" or "Error", one line per input line
+
+	Memory stays bounded by the block size, whatever the input size.
+*/
+class	RPNBatch
+{
+	public:
+		RPNBatch();
+		explicit RPNBatch(size_t workers);
+		~RPNBatch();
+		RPNBatch(const RPNBatch &other);
+		RPNBatch	&operator=(const RPNBatch &other);
+
+		// Returns the number of expressions that gave "Error"
+		size_t	run(std::istream &input, std::ostream &output);
+
+	private:
+		struct Worker
+		{
+			RPNBatch	*batch;
+			RPN			rpn;
+		};
+
+		size_t						_workerCount;
+		// Current block, shared by the workers
+		std::vector<std::string>	_lines;
+		std::vector<long>			_results;
+		std::vector<char>			_success;
+		size_t						_nextSlice;
+		pthread_mutex_t				_sliceMutex;
+
+		static void	*workerRoutine(void *arg);
+		bool		claimSlice(size_t &begin, size_t &end);
+		void		evaluateBlock(std::vector<Worker> &workers);
+		size_t		writeBlock(std::ostream &output) const;
+};
+
+#endif
@@ -0,0 +1,187 @@
+#include "RPNCache.hpp"
+
+#define NO_ENTRY static_cast<size_t>(-1)
+#define FNV_OFFSET 14695981039346656037UL
+#define FNV_PRIME 1099511628211UL
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNCache::RPNCache():
+	_capacity(0),
+	_entries(),
+	_buckets(1, NO_ENTRY),
+	_newest(NO_ENTRY),
+	_oldest(NO_ENTRY),
+	_hits(0),
+	_misses(0)
+{}
+
+RPNCache::RPNCache(size_t capacity):
+	_capacity(capacity > RPN_CACHE_MAX ? RPN_CACHE_MAX : capacity),
+	_entries(),
+	_buckets(),
+	_newest(NO_ENTRY),
+	_oldest(NO_ENTRY),
+	_hits(0),
+	_misses(0)
+{
+	size_t	buckets = 1;
+	while (buckets / 2 < _capacity) // at least 2 * capacity, without overflowing
+		buckets *= 2;
+	_buckets.assign(buckets, NO_ENTRY);
+	_entries.reserve(_capacity);
+}
+
+RPNCache::~RPNCache()
+{}
+
+// Links are indices, a plain copy of the vectors stays consistent
+RPNCache::RPNCache(const RPNCache &other):
+	_capacity(other._capacity),
+	_entries(other._entries),
+	_buckets(other._buckets),
+	_newest(other._newest),
+	_oldest(other._oldest),
+	_hits(other._hits),
+	_misses(other._misses)
+{}
+
+RPNCache	&RPNCache::operator=(const RPNCache &other)
+{
+	if (this != &other)
+	{
+		this->_capacity = other._capacity;
+		this->_entries = other._entries;
+		this->_buckets = other._buckets;
+		this->_newest = other._newest;
+		this->_oldest = other._oldest;
+		this->_hits = other._hits;
+		this->_misses = other._misses;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+const RPNProgram	*RPNCache::find(const std::string &expression, bool &compiled)
+{
+	unsigned long	hash = hashExpression(expression);
+	size_t			index = _buckets[hash & (_buckets.size() - 1)];
+	while (index != NO_ENTRY)
+	{
+		Entry	&entry = _entries[index];
+		if (entry.hash == hash && entry.expression == expression)
+		{
+			if (index != _newest)
+			{
+				unlinkRecency(index);
+				linkNewest(index);
+			}
+			_hits++;
+			compiled = entry.compiled;
+			return (&entry.program);
+		}
+		index = entry.chain;
+	}
+	_misses++;
+	return (0);
+}
+
+// Callers insert after a miss only: the text is not already cached
+void	RPNCache::insert(const std::string &expression, const RPNProgram &program, bool compiled)
+{
+	if (_capacity == 0)
+		return ;
+	size_t	index = _entries.size();
+	if (index < _capacity)
+		_entries.push_back(Entry());
+	else
+	{
+		index = _oldest;
+		unlinkChain(index);
+		unlinkRecency(index);
+	}
+	Entry	&entry = _entries[index];
+	entry.expression = expression;
+	entry.hash = hashExpression(expression);
+	entry.program = program;
+	entry.compiled = compiled;
+
+	size_t	&bucket = _buckets[entry.hash & (_buckets.size() - 1)];
+	entry.chain = bucket;
+	bucket = index;
+	linkNewest(index);
+}
+
+size_t	RPNCache::capacity() const
+{
+	return (_capacity);
+}
+
+size_t	RPNCache::size() const
+{
+	return (_entries.size());
+}
+
+unsigned long	RPNCache::hits() const
+{
+	return (_hits);
+}
+
+unsigned long	RPNCache::misses() const
+{
+	return (_misses);
+}
+
+// =============================================================================
+// Links
+// =============================================================================
+
+// FNV-1a, 64 bit: one xor and one multiply per byte
+unsigned long	RPNCache::hashExpression(const std::string &expression)
+{
+	unsigned long	hash = FNV_OFFSET;
+	for (size_t i = 0; i < expression.size(); i++)
+	{
+		hash ^= static_cast<unsigned char>(expression[i]);
+		hash *= FNV_PRIME;
+	}
+	return (hash);
+}
+
+void	RPNCache::unlinkChain(size_t index)
+{
+	size_t	*link = &_buckets[_entries[index].hash & (_buckets.size() - 1)];
+	while (*link != index)
+		link = &_entries[*link].chain;
+	*link = _entries[index].chain;
+}
+
+void	RPNCache::unlinkRecency(size_t index)
+{
+	Entry	&entry = _entries[index];
+	if (entry.newer != NO_ENTRY)
+		_entries[entry.newer].older = entry.older;
+	else
+		_newest = entry.older;
+	if (entry.older != NO_ENTRY)
+		_entries[entry.older].newer = entry.newer;
+	else
+		_oldest = entry.newer;
+}
+
+void	RPNCache::linkNewest(size_t index)
+{
+	Entry	&entry = _entries[index];
+	entry.newer = NO_ENTRY;
+	entry.older = _newest;
+	if (_newest != NO_ENTRY)
+		_entries[_newest].newer = index;
+	_newest = index;
+	if (_oldest == NO_ENTRY)
+		_oldest = index;
+}
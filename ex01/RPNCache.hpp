@@ -0,0 +1,72 @@
+#ifndef RPNCACHE_HPP
+# define RPNCACHE_HPP
+
+#include "RPNProgram.hpp"
+#include <string>
+#include <vector>
+
+# define RPN_CACHE_MAX (static_cast<size_t>(1) << 24) // entries, a larger capacity is clamped
+
+/*
+	LRU cache of compiled expressions, keyed by the expression text.
+
+	Fixed capacity, every entry lives in one vector for the whole life of
+	the cache. Two intrusive index links per entry:
+	- hash chain: buckets[fnv1a(text) & mask] -> entry -> entry ...
+	- recency list: newest <-> ... <-> oldest
+	A hit moves the entry to the newest end, a miss on a full cache reuses
+	the oldest entry in place. No allocation once the cache is warm
+	(beyond what the copied program or text may need).
+
+	An expression with an invalid token is cached too (compiled = false),
+	so repeated garbage is rejected without parsing it again.
+
+	Capacity 0 disables the cache: find() always misses, insert() does nothing.
+	Capacity is at most RPN_CACHE_MAX entries (buckets: 2^25 indices).
+*/
+class	RPNCache
+{
+	public:
+		RPNCache();
+		explicit RPNCache(size_t capacity);
+		~RPNCache();
+		RPNCache(const RPNCache &other);
+		RPNCache	&operator=(const RPNCache &other);
+
+		// 0 on a miss; `compiled` false = cached as an invalid expression
+		const RPNProgram	*find(const std::string &expression, bool &compiled);
+		void				insert(const std::string &expression, const RPNProgram &program,
+									bool compiled);
+
+		size_t			capacity() const;
+		size_t			size() const;
+		unsigned long	hits() const;
+		unsigned long	misses() const;
+
+	private:
+		struct Entry
+		{
+			std::string		expression;
+			unsigned long	hash;
+			RPNProgram		program;
+			bool			compiled;
+			size_t			chain;	// next entry of the same bucket
+			size_t			newer;
+			size_t			older;
+		};
+
+		size_t				_capacity;
+		std::vector<Entry>	_entries;
+		std::vector<size_t>	_buckets;	// power of two >= 2 * capacity
+		size_t				_newest;
+		size_t				_oldest;
+		unsigned long		_hits;
+		unsigned long		_misses;
+
+		static unsigned long	hashExpression(const std::string &expression);
+		void					unlinkChain(size_t index);
+		void					unlinkRecency(size_t index);
+		void					linkNewest(size_t index);
+};
+
+#endif
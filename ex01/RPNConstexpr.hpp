@@ -0,0 +1,120 @@
+#ifndef RPNCONSTEXPR_HPP
+# define RPNCONSTEXPR_HPP
+
+#if __cplusplus < 201402L
+# error "RPNConstexpr.hpp needs C++14 (make constexpr), the rest of RPN stays C++98"
+#endif
+
+#include <climits> // LONG_MAX, LONG_MIN
+#include <cstddef>
+#include <type_traits> // std::integral_constant
+
+/*
+	RPN evaluated by the compiler: a constant written as an expression
+	costs nothing at run time.
+
+		constexpr long	g_timeout = RPNConstexpr::evaluate("6 5 * 2 *");	// 60
+		char			buffer[RPN_CONSTANT("8 8 *")];						// 64
+
+	Same grammar, stack rules and checked arithmetic as
+	RPN::calculateExpression. A constexpr function has to be a single
+	loop over the literal, so the evaluator is written again here (C++14
+	constexpr, no template recursion), and the difftest-like table of
+	RPN_constexpr.cpp keeps both in agreement.
+
+	An error is a compile error: the evaluation reaches a function that
+	is not constexpr, and its name is the diagnostic:
+		RPN_CONSTANT("8 0 /")
+		error: call to non-'constexpr' function 'static void RPNConstexpr::divisionByZero()'
+	Those functions are never defined: called at run time (evaluate() on
+	an array that is not a constant), the same error stops the link.
+
+	RPN_CONSTANT forces the evaluation at compile time even where the
+	value is not needed as a constant (a plain `long x = ...`).
+*/
+class	RPNConstexpr
+{
+	public:
+		template <size_t Size>
+		static constexpr long	evaluate(const char (&expression)[Size])
+		{
+			long	stack[Size / 2 + 1] = {}; // one byte tokens + separators: at most that many operands
+			size_t	depth = 0;
+			size_t	i = 0;
+			while (i < Size && expression[i] != '\0')
+			{
+				if (isSpace(expression[i]))
+				{
+					i++;
+					continue;
+				}
+				char	token = expression[i];
+				if (i + 1 < Size && expression[i + 1] != '\0' && !isSpace(expression[i + 1]))
+					invalidToken(); // longer than one byte
+				i++;
+				if (token >= '0' && token <= '9')
+				{
+					stack[depth++] = token - '0';
+					continue;
+				}
+				if (token != '+' && token != '-' && token != '*' && token != '/')
+					invalidToken();
+				if (depth < 2)
+					underflow();
+				long	rhs = stack[--depth];
+				stack[depth - 1] = apply(stack[depth - 1], rhs, token);
+			}
+			if (depth != 1)
+				leftover();
+			return (stack[0]);
+		}
+
+	private:
+		static constexpr bool	isSpace(char c)
+		{
+			return (c == ' ' || (c >= '\t' && c <= '\r'));
+		}
+
+		// The checks of CheckedArithmetic (Arithmetic.hpp)
+		static constexpr long	apply(long a, long b, char op)
+		{
+			if (op == '+')
+			{
+				if ((b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b))
+					overflow();
+				return (a + b);
+			}
+			if (op == '-')
+			{
+				if ((b > 0 && a < LONG_MIN + b) || (b < 0 && a > LONG_MAX + b))
+					overflow();
+				return (a - b);
+			}
+			if (op == '*')
+			{
+				if (a == 0 || b == 0)
+					return (0);
+				if ((a > 0 && b > 0 && a > LONG_MAX / b) || (a > 0 && b < 0 && b < LONG_MIN / a)
+					|| (a < 0 && b > 0 && a < LONG_MIN / b) || (a < 0 && b < 0 && a < LONG_MAX / b))
+					overflow();
+				return (a * b);
+			}
+			if (b == 0)
+				divisionByZero();
+			if (a == LONG_MIN && b == -1)
+				overflow();
+			return (a / b);
+		}
+
+		// Not constexpr, not defined: reaching one is the error
+		static void	invalidToken();
+		static void	underflow();
+		static void	leftover();
+		static void	overflow();
+		static void	divisionByZero();
+};
+
+# define RPN_CONSTANT(expression) \
+	(std::integral_constant<long, RPNConstexpr::evaluate(expression)>::value)
+
+#endif
@@ -0,0 +1,179 @@
+#include "RPNIncremental.hpp"
+#include "RPNTokenizer.hpp"
+#include "Arithmetic.hpp"
+
+#define NO_PENDING -1
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNIncremental::RPNIncremental():
+	_stack(),
+	_pending(NO_PENDING),
+	_failed(false),
+	_bytes(0),
+	_profile()
+{}
+
+RPNIncremental::~RPNIncremental()
+{}
+
+RPNIncremental::RPNIncremental(const RPNIncremental &other):
+	_stack(other._stack),
+	_pending(other._pending),
+	_failed(other._failed),
+	_bytes(other._bytes),
+	_profile(other._profile)
+{}
+
+RPNIncremental	&RPNIncremental::operator=(const RPNIncremental &other)
+{
+	if (this != &other)
+	{
+		this->_stack = other._stack;
+		this->_pending = other._pending;
+		this->_failed = other._failed;
+		this->_bytes = other._bytes;
+		this->_profile = other._profile;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+/*
+	`_pending` is the token byte not yet ended by whitespace, kept from
+	the previous call:
+		"3 4 + 7" -> 3, 4, + evaluated, '7' pending
+		" *"      -> space: 7 pushed, then '*' pending
+	A second non-space byte after it ("7" + "7") is an invalid token.
+*/
+bool	RPNIncremental::feed(const char *data, size_t size)
+{
+	if (_failed)
+		return (false);
+	_bytes += size;
+	for (size_t i = 0; i < size; i++)
+	{
+		unsigned char	c = static_cast<unsigned char>(data[i]);
+		if (RPNTokenizer::isSpace(c))
+		{
+			if (_pending != NO_PENDING && applyToken(static_cast<char>(_pending)) == false)
+				return (fail());
+			_pending = NO_PENDING;
+		}
+		else if (_pending != NO_PENDING)
+		{
+#ifdef RPN_PROFILE
+			_profile.recordReject(RPNProfile::REJECT_INVALID_TOKEN);
+#endif
+			return (fail()); // token longer than one byte
+		}
+		else
+			_pending = c;
+	}
+	return (true);
+}
+
+// End of the expression: the pending byte is a token, exactly 1 operand left
+bool	RPNIncremental::finish(long &output)
+{
+#ifdef RPN_PROFILE
+	_profile.recordExpression();
+#endif
+	bool	success = !_failed
+		&& (_pending == NO_PENDING || applyToken(static_cast<char>(_pending)));
+	if (success && _stack.size() != 1)
+	{
+#ifdef RPN_PROFILE
+		_profile.recordReject(RPNProfile::REJECT_LEFTOVER);
+#endif
+		success = false;
+	}
+	if (success)
+		output = _stack.top();
+	reset();
+	return (success);
+}
+
+void	RPNIncremental::reset()
+{
+	_stack.clear();
+	_pending = NO_PENDING;
+	_failed = false;
+	_bytes = 0;
+}
+
+bool	RPNIncremental::failed() const
+{
+	return (_failed);
+}
+
+size_t	RPNIncremental::depth() const
+{
+	return (_stack.size());
+}
+
+size_t	RPNIncremental::bytesFed() const
+{
+	return (_bytes);
+}
+
+const RPNProfile	&RPNIncremental::profile() const
+{
+	return (_profile);
+}
+
+// =============================================================================
+// Tokens
+// =============================================================================
+
+bool	RPNIncremental::fail()
+{
+	_failed = true;
+	_stack.clear();
+	return (false);
+}
+
+// The operator works in place on the new top: one pop instead of two pops and a push
+bool	RPNIncremental::applyToken(char token)
+{
+	if (token >= '0' && token <= '9')
+	{
+		_stack.push(token - '0');
+#ifdef RPN_PROFILE
+		_profile.recordDepth(_stack.size());
+#endif
+		return (true);
+	}
+	if (!RPNTokenizer::isOperatorChar(token) || _stack.size() < 2)
+	{
+#ifdef RPN_PROFILE
+		_profile.recordReject(RPNTokenizer::isOperatorChar(token)
+			? RPNProfile::REJECT_UNDERFLOW : RPNProfile::REJECT_INVALID_TOKEN);
+#endif
+		return (false);
+	}
+	long	rhs = _stack.top();
+	_stack.pop();
+	long	&lhs = _stack.top();
+#ifdef RPN_PROFILE
+	unsigned long long	start = RPNProfile::now();
+#endif
+	bool	ok = false;
+	if (token == '+')
+		ok = CheckedArithmetic::add(lhs, rhs, lhs);
+	else if (token == '-')
+		ok = CheckedArithmetic::sub(lhs, rhs, lhs);
+	else if (token == '*')
+		ok = CheckedArithmetic::mul(lhs, rhs, lhs);
+	else
+		ok = CheckedArithmetic::div(lhs, rhs, lhs);
+#ifdef RPN_PROFILE
+	_profile.recordOperation(token, rhs, ok, start);
+#endif
+	return (ok);
+}
@@ -0,0 +1,59 @@
+#ifndef RPNINCREMENTAL_HPP
+# define RPNINCREMENTAL_HPP
+
+#include "OperandStack.hpp"
+#include "RPNProfile.hpp"
+#include <cstddef>
+
+/*
+	Push parser: the expression is given in pieces, as it arrives
+	(socket reads, pipe blocks), and evaluated while it arrives.
+
+		RPNIncremental	rpn;
+		rpn.feed("3 4 + ", 6);     3, 4, + evaluated, stack [7]
+		rpn.feed("2", 1);          '2' pending: "2" or "21"?
+		rpn.feed(" *", 2);         2 pushed, '*' pending
+		rpn.finish(result);        '*' evaluated, result = 14
+
+	Same grammar and results as RPN::calculateExpression, whatever the
+	cut points. A valid token is one byte, so between two calls the only
+	state besides the stack is that byte, waiting for the whitespace (or
+	the finish()) that ends it: memory is the stack, never the text.
+
+	An error stops the evaluation at once: feed() returns false from then
+	on, without reading its input (a server can drop the rest of the
+	request), and finish() returns false. finish() always starts a new
+	expression, so one object serves a whole connection; reset() drops
+	the current one.
+*/
+class	RPNIncremental
+{
+	public:
+		RPNIncremental();
+		~RPNIncremental();
+		RPNIncremental(const RPNIncremental &other);
+		RPNIncremental	&operator=(const RPNIncremental &other);
+
+		bool	feed(const char *data, size_t size);
+		bool	finish(long &output);
+		void	reset();
+
+		bool	failed() const;
+		size_t	depth() const;		// operands on the stack now
+		size_t	bytesFed() const;	// since the expression started
+
+		// Counters of a -DRPN_PROFILE build (see RPNProfile)
+		const RPNProfile	&profile() const;
+
+	private:
+		OperandStack<long, 32>	_stack;
+		int						_pending;	// token byte not ended yet, or NO_PENDING
+		bool					_failed;
+		size_t					_bytes;
+		RPNProfile				_profile;
+
+		bool	fail();
+		bool	applyToken(char token);
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "RPNInfix.hpp"
+#include "RPNTokenizer.hpp"
+#include <climits> // LONG_MAX
+
+#define NEGATION 'u'
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNInfix::RPNInfix():
+	_operators()
+{}
+
+RPNInfix::~RPNInfix()
+{}
+
+RPNInfix::RPNInfix(const RPNInfix &other):
+	_operators(other._operators)
+{}
+
+RPNInfix	&RPNInfix::operator=(const RPNInfix &other)
+{
+	if (this != &other)
+		this->_operators = other._operators;
+	return (*this);
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+bool	RPNInfix::compile(const std::string &expression, RPNProgram &program)
+{
+	return (compile(expression.data(), expression.size(), program));
+}
+
+/*
+	expectOperand is the whole grammar: true at the start, after an
+	operator and after '(' ; false after a number, a variable or ')'.
+	"3 4", "3 +", "( )" and "+ * 2" all break it.
+*/
+bool	RPNInfix::compile(const char *data, size_t size, RPNProgram &program)
+{
+	program.clear();
+	_operators.clear();
+
+	bool	expectOperand = true;
+	size_t	pos = 0;
+	while (pos < size)
+	{
+		char	c = data[pos];
+		if (RPNTokenizer::isSpace(static_cast<unsigned char>(c)))
+		{
+			pos++;
+			continue;
+		}
+		if (c >= '0' && c <= '9')
+		{
+			if (expectOperand == false || readNumber(data, size, pos, program) == false)
+				return (false);
+			expectOperand = false;
+			continue;
+		}
+		if (c >= 'a' && c <= 'z')
+		{
+			if (expectOperand == false)
+				return (false);
+			program.emit(RPNProgram::OP_LOAD, c - 'a');
+			expectOperand = false;
+		}
+		else if (c == '(')
+		{
+			if (expectOperand == false)
+				return (false);
+			_operators.push('(');
+		}
+		else if (c == ')')
+		{
+			if (expectOperand == true || closeParenthesis(program) == false)
+				return (false);
+		}
+		else if (RPNTokenizer::isOperatorChar(c))
+		{
+			if (expectOperand == false)
+			{
+				pushBinary(c, program);
+				expectOperand = true;
+			}
+			else if (c == '-')
+			{
+				program.emit(RPNProgram::OP_PUSH, 0); // -x is 0 x -
+				_operators.push(NEGATION);
+			}
+			else if (c != '+') // a leading + changes nothing
+				return (false);
+		}
+		else
+			return (false);
+		pos++;
+	}
+	if (expectOperand == true)
+		return (false);
+	return (flush(program));
+}
+
+// =============================================================================
+// Shunting-Yard
+// =============================================================================
+
+int	RPNInfix::precedence(char op)
+{
+	if (op == NEGATION)
+		return (3);
+	if (op == '*' || op == '/')
+		return (2);
+	if (op == '+' || op == '-')
+		return (1);
+	return (0); // '(' : never popped by an operator
+}
+
+void	RPNInfix::emitOperator(char op, RPNProgram &program)
+{
+	if (op == '+')
+		program.emit(RPNProgram::OP_ADD, 0);
+	else if (op == '-' || op == NEGATION)
+		program.emit(RPNProgram::OP_SUB, 0);
+	else if (op == '*')
+		program.emit(RPNProgram::OP_MUL, 0);
+	else
+		program.emit(RPNProgram::OP_DIV, 0);
+}
+
+// Decimal digits at pos, false if the value does not fit in a long
+bool	RPNInfix::readNumber(const char *data, size_t size, size_t &pos, RPNProgram &program) const
+{
+	long	value = 0;
+	while (pos < size && data[pos] >= '0' && data[pos] <= '9')
+	{
+		long	digit = data[pos] - '0';
+		if (value > (LONG_MAX - digit) / 10)
+			return (false);
+		value = value * 10 + digit;
+		pos++;
+	}
+	program.emit(RPNProgram::OP_PUSH, value);
+	return (true);
+}
+
+// Left associative: "8 - 2 - 1" pops the first - before pushing the second
+void	RPNInfix::pushBinary(char op, RPNProgram &program)
+{
+	while (!_operators.empty() && precedence(_operators.top()) >= precedence(op))
+	{
+		emitOperator(_operators.top(), program);
+		_operators.pop();
+	}
+	_operators.push(op);
+}
+
+bool	RPNInfix::closeParenthesis(RPNProgram &program)
+{
+	while (!_operators.empty() && _operators.top() != '(')
+	{
+		emitOperator(_operators.top(), program);
+		_operators.pop();
+	}
+	if (_operators.empty())
+		return (false); // ')' without '('
+	_operators.pop();
+	return (true);
+}
+
+bool	RPNInfix::flush(RPNProgram &program)
+{
+	while (!_operators.empty())
+	{
+		if (_operators.top() == '(')
+			return (false); // '(' never closed
+		emitOperator(_operators.top(), program);
+		_operators.pop();
+	}
+	return (true);
+}
@@ -0,0 +1,60 @@
+#ifndef RPNINFIX_HPP
+# define RPNINFIX_HPP
+
+#include "RPNProgram.hpp"
+#include "OperandStack.hpp"
+#include <string>
+
+/*
+	Infix front-end: "3 + 4 * (2 - 1)" -> the program of "3 4 2 1 - * +"
+
+	Shunting-Yard in one pass over the bytes. Operands are emitted into
+	the RPNProgram as soon as they are read, operators wait on a small
+	stack until an operator of lower or equal precedence (or a closing
+	parenthesis) arrives. No postfix string is ever built.
+
+		input     emitted        operators
+		3         PUSH 3
+		+                        +
+		4         PUSH 4         +
+		*                        + *
+		(                        + * (
+		2         PUSH 2         + * (
+		-                        + * ( -
+		1         PUSH 1         + * ( -
+		)         SUB            + *
+		end       MUL, ADD
+
+	Grammar:
+	- numbers are non-negative integers ("12" is allowed here, no need
+	  for spaces: "12+3"), variables are a..z like RPN::compile
+	- * and / bind tighter than + and -, all of them are left associative
+	- a leading - is a negation: "-x" is compiled as "0 x -", so it fails
+	  on LONG_MIN exactly like the postfix form; a leading + is ignored
+
+	Only the syntax is checked here, overflow and division by zero are
+	found by RPN::evaluate like for any other program.
+*/
+class	RPNInfix
+{
+	public:
+		RPNInfix();
+		~RPNInfix();
+		RPNInfix(const RPNInfix &other);
+		RPNInfix	&operator=(const RPNInfix &other);
+
+		bool	compile(const std::string &expression, RPNProgram &program);
+		bool	compile(const char *data, size_t size, RPNProgram &program);
+
+	private:
+		OperandStack<char, 32>	_operators; // '(' , + - * / and 'u' (negation)
+
+		static int	precedence(char op);
+		static void	emitOperator(char op, RPNProgram &program);
+		bool		readNumber(const char *data, size_t size, size_t &pos, RPNProgram &program) const;
+		void		pushBinary(char op, RPNProgram &program);
+		bool		closeParenthesis(RPNProgram &program);
+		bool		flush(RPNProgram &program);
+};
+
+#endif
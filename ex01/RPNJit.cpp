@@ -0,0 +1,420 @@
+#include "RPNJit.hpp"
+#include <cstring> // memcpy
+#include <climits> // LONG_MIN
+#include <sys/mman.h>
+#include <unistd.h> // sysconf
+
+#define REGISTER_SLOTS 8
+#define FRAME_SLOTS_MAX 512 // one 4 KiB page: sub rsp stays within the stack guard
+
+// x86-64 register numbers
+#define RAX 0
+#define RCX 1
+#define RDX 2
+#define RSP 4
+#define RSI 6
+#define RDI 7
+#define R8 8
+
+// Condition codes for jcc rel32 (0F 80+cc)
+#define CC_OVERFLOW 0x0
+#define CC_EQUAL 0x4
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNJit::RPNJit():
+	_program(),
+	_interpreter(),
+	_page(0),
+	_pageSize(0),
+	_function(0)
+{}
+
+RPNJit::~RPNJit()
+{
+	release();
+}
+
+// Native code is never shared: the copy generates its own page
+RPNJit::RPNJit(const RPNJit &other):
+	_program(),
+	_interpreter(),
+	_page(0),
+	_pageSize(0),
+	_function(0)
+{
+	compile(other._program);
+}
+
+RPNJit	&RPNJit::operator=(const RPNJit &other)
+{
+	if (this != &other)
+		compile(other._program);
+	return (*this);
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+bool	RPNJit::compile(const RPNProgram &program)
+{
+	release();
+	_program = program;
+#if defined(__x86_64__)
+	size_t	maxDepth = 0;
+	if (program.measureDepth(maxDepth) == false)
+		return (false);
+	Emitter	emitter;
+	if (generate(program, maxDepth, emitter) == false)
+		return (false);
+
+	long	page = sysconf(_SC_PAGESIZE);
+	if (page <= 0)
+		page = 4096;
+	_pageSize = ((emitter.code.size() + page - 1) / page) * page;
+	void	*memory = mmap(0, _pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		_pageSize = 0;
+		return (false);
+	}
+	std::memcpy(memory, &emitter.code[0], emitter.code.size());
+	if (mprotect(memory, _pageSize, PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(memory, _pageSize);
+		_pageSize = 0;
+		return (false);
+	}
+	_page = memory;
+	std::memcpy(&_function, &_page, sizeof(_function)); // object -> function pointer
+	return (true);
+#else
+	return (false);
+#endif
+}
+
+bool	RPNJit::isNative() const
+{
+	return (_function != 0);
+}
+
+bool	RPNJit::run(const long *variables, long &output)
+{
+	if (_function == 0)
+		return (_interpreter.evaluate(_program, variables, output));
+	if (_program.variableCount() > 0 && variables == 0)
+		return (false);
+	return (_function(variables, &output) != 0);
+}
+
+void	RPNJit::release()
+{
+	if (_page != 0)
+		munmap(_page, _pageSize);
+	_page = 0;
+	_pageSize = 0;
+	_function = 0;
+}
+
+// =============================================================================
+// Code Generation
+// =============================================================================
+
+void	RPNJit::emitByte(Emitter &emitter, unsigned char byte)
+{
+	emitter.code.push_back(byte);
+}
+
+void	RPNJit::emitInt32(Emitter &emitter, int value)
+{
+	unsigned int	bits = static_cast<unsigned int>(value);
+	for (int i = 0; i < 4; i++)
+		emitByte(emitter, static_cast<unsigned char>((bits >> (8 * i)) & 0xFF));
+}
+
+void	RPNJit::emitInt64(Emitter &emitter, long value)
+{
+	unsigned long	bits = static_cast<unsigned long>(value);
+	for (int i = 0; i < 8; i++)
+		emitByte(emitter, static_cast<unsigned char>((bits >> (8 * i)) & 0xFF));
+}
+
+/*
+	REX prefix: 0100 W R X B
+	W = 64 bit operand, R extends ModRM.reg, B extends ModRM.rm
+*/
+static unsigned char	rex(int reg, int rm)
+{
+	return (static_cast<unsigned char>(0x48 | ((reg >= 8) ? 0x04 : 0) | ((rm >= 8) ? 0x01 : 0)));
+}
+
+static unsigned char	modrmDirect(int reg, int rm)
+{
+	return (static_cast<unsigned char>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// mov dst, src   (89 /r)
+void	RPNJit::emitMovRegReg(Emitter &emitter, int dst, int src)
+{
+	if (dst == src)
+		return ;
+	emitByte(emitter, rex(src, dst));
+	emitByte(emitter, 0x89);
+	emitByte(emitter, modrmDirect(src, dst));
+}
+
+// movabs reg, imm64   (REX.W B8+r)
+void	RPNJit::emitMovRegImm(Emitter &emitter, int reg, long value)
+{
+	emitByte(emitter, rex(0, reg));
+	emitByte(emitter, static_cast<unsigned char>(0xB8 + (reg & 7)));
+	emitInt64(emitter, value);
+}
+
+/*
+	Slots 0..7 are r8..r15, the others are [rsp + 8 * (slot - 8)]
+	mov reg, [rsp + disp32]   (8B /r, ModRM 10 reg 100, SIB 24)
+*/
+void	RPNJit::emitLoadSlot(Emitter &emitter, int reg, size_t slot)
+{
+	if (slot < REGISTER_SLOTS)
+	{
+		emitMovRegReg(emitter, reg, R8 + static_cast<int>(slot));
+		return ;
+	}
+	emitByte(emitter, rex(reg, RSP));
+	emitByte(emitter, 0x8B);
+	emitByte(emitter, static_cast<unsigned char>(0x84 | ((reg & 7) << 3)));
+	emitByte(emitter, 0x24);
+	emitInt32(emitter, static_cast<int>(8 * (slot - REGISTER_SLOTS)));
+}
+
+void	RPNJit::emitStoreSlot(Emitter &emitter, size_t slot, int reg)
+{
+	if (slot < REGISTER_SLOTS)
+	{
+		emitMovRegReg(emitter, R8 + static_cast<int>(slot), reg);
+		return ;
+	}
+	emitByte(emitter, rex(reg, RSP));
+	emitByte(emitter, 0x89);
+	emitByte(emitter, static_cast<unsigned char>(0x84 | ((reg & 7) << 3)));
+	emitByte(emitter, 0x24);
+	emitInt32(emitter, static_cast<int>(8 * (slot - REGISTER_SLOTS)));
+}
+
+// mov reg, [rdi + 8 * index]   (8B /r, ModRM 10 reg 111)
+void	RPNJit::emitLoadVariable(Emitter &emitter, int reg, long index)
+{
+	emitByte(emitter, rex(reg, RDI));
+	emitByte(emitter, 0x8B);
+	emitByte(emitter, static_cast<unsigned char>(0x80 | ((reg & 7) << 3) | RDI));
+	emitInt32(emitter, static_cast<int>(8 * index));
+}
+
+// jcc rel32 to the fail label, patched at the end
+void	RPNJit::emitJumpToFail(Emitter &emitter, unsigned char condition)
+{
+	emitByte(emitter, 0x0F);
+	emitByte(emitter, static_cast<unsigned char>(0x80 | condition));
+	emitter.failJumps.push_back(emitter.code.size());
+	emitInt32(emitter, 0);
+}
+
+/*
+	lhs = slot n, rhs = slot n+1, result goes back to slot n.
+	Both in registers: operate in place (add r8, r9 ; jo fail)
+	Otherwise through rax / rcx.
+*/
+void	RPNJit::emitBinary(Emitter &emitter, RPNProgram::OpCode opcode, size_t lhsSlot)
+{
+	bool	inRegisters = (lhsSlot + 1 < REGISTER_SLOTS);
+	int		lhs = inRegisters ? R8 + static_cast<int>(lhsSlot) : RAX;
+	int		rhs = inRegisters ? R8 + static_cast<int>(lhsSlot) + 1 : RCX;
+
+	if (opcode == RPNProgram::OP_DIV)
+	{
+		emitLoadSlot(emitter, RAX, lhsSlot);
+		emitLoadSlot(emitter, RCX, lhsSlot + 1);
+		emitDivide(emitter);
+		emitStoreSlot(emitter, lhsSlot, RAX);
+		return ;
+	}
+	if (!inRegisters)
+	{
+		emitLoadSlot(emitter, RAX, lhsSlot);
+		emitLoadSlot(emitter, RCX, lhsSlot + 1);
+	}
+	if (opcode == RPNProgram::OP_ADD || opcode == RPNProgram::OP_SUB)
+	{
+		emitByte(emitter, rex(rhs, lhs)); // add/sub lhs, rhs   (01 /r, 29 /r)
+		emitByte(emitter, opcode == RPNProgram::OP_ADD ? 0x01 : 0x29);
+		emitByte(emitter, modrmDirect(rhs, lhs));
+	}
+	else
+	{
+		emitByte(emitter, rex(lhs, rhs)); // imul lhs, rhs   (0F AF /r)
+		emitByte(emitter, 0x0F);
+		emitByte(emitter, 0xAF);
+		emitByte(emitter, modrmDirect(lhs, rhs));
+	}
+	emitJumpToFail(emitter, CC_OVERFLOW);
+	if (!inRegisters)
+		emitStoreSlot(emitter, lhsSlot, RAX);
+}
+
+/*
+	rax = rax / rcx, same failures as safeDiv
+		test rcx, rcx         ; je fail        (division by zero)
+		cmp rcx, -1           ; jne divide
+		movabs rdx, LONG_MIN
+		cmp rax, rdx          ; je fail        (LONG_MIN / -1)
+	divide:
+		cqo
+		idiv rcx
+*/
+void	RPNJit::emitDivide(Emitter &emitter)
+{
+	emitByte(emitter, 0x48);
+	emitByte(emitter, 0x85);
+	emitByte(emitter, 0xC9);
+	emitJumpToFail(emitter, CC_EQUAL);
+	emitByte(emitter, 0x48);
+	emitByte(emitter, 0x83);
+	emitByte(emitter, 0xF9);
+	emitByte(emitter, 0xFF);
+	emitByte(emitter, 0x75); // jne rel8 over the next 19 bytes
+	emitByte(emitter, 19);
+	emitMovRegImm(emitter, RDX, LONG_MIN);	// 10 bytes
+	emitByte(emitter, 0x48);				// 3 bytes: cmp rax, rdx
+	emitByte(emitter, 0x39);
+	emitByte(emitter, 0xD0);
+	emitJumpToFail(emitter, CC_EQUAL);		// 6 bytes
+	emitByte(emitter, 0x48);
+	emitByte(emitter, 0x99);
+	emitByte(emitter, 0x48);
+	emitByte(emitter, 0xF7);
+	emitByte(emitter, 0xF9);
+}
+
+/*
+	int function(const long *variables (rdi), long *output (rsi))
+
+	push r12..r15 ; sub rsp, frame
+	<body>
+	mov rax, slot0 ; mov [rsi], rax ; mov eax, 1
+done:
+	add rsp, frame ; pop r15..r12 ; ret
+fail:
+	xor eax, eax ; jmp done
+*/
+bool	RPNJit::generate(const RPNProgram &program, size_t maxDepth, Emitter &emitter)
+{
+	// temps (SAVE / RECALL) are frame slots after the deepest stack slot
+	size_t	tempBase = (maxDepth > REGISTER_SLOTS) ? maxDepth : REGISTER_SLOTS;
+	size_t	frameSlots = tempBase + program.tempCount() - REGISTER_SLOTS;
+	if (frameSlots > FRAME_SLOTS_MAX)
+		return (false); // deeper programs run in the interpreter
+	emitter.frameSize = ((8 * frameSlots + 15) / 16) * 16;
+
+	for (int reg = 12; reg <= 15; reg++)
+	{
+		emitByte(emitter, 0x41);
+		emitByte(emitter, static_cast<unsigned char>(0x50 + (reg & 7)));
+	}
+	emitByte(emitter, 0x48);
+	emitByte(emitter, 0x81);
+	emitByte(emitter, 0xEC);
+	emitInt32(emitter, static_cast<int>(emitter.frameSize));
+
+	size_t	depth = 0;
+	for (size_t i = 0; i < program.size(); i++)
+	{
+		const RPNProgram::Instruction	&instruction = program[i];
+		if (instruction.opcode == RPNProgram::OP_PUSH || instruction.opcode == RPNProgram::OP_LOAD)
+		{
+			int	reg = (depth < REGISTER_SLOTS) ? R8 + static_cast<int>(depth) : RAX;
+			if (instruction.opcode == RPNProgram::OP_PUSH)
+				emitMovRegImm(emitter, reg, instruction.operand);
+			else
+				emitLoadVariable(emitter, reg, instruction.operand);
+			if (reg == RAX)
+				emitStoreSlot(emitter, depth, RAX);
+			depth++;
+			continue;
+		}
+		if (instruction.opcode == RPNProgram::OP_SAVE)
+		{
+			emitLoadSlot(emitter, RAX, depth - 1);
+			emitStoreSlot(emitter, tempBase + instruction.operand, RAX);
+			continue;
+		}
+		if (instruction.opcode == RPNProgram::OP_RECALL)
+		{
+			emitLoadSlot(emitter, RAX, tempBase + instruction.operand);
+			emitStoreSlot(emitter, depth, RAX);
+			depth++;
+			continue;
+		}
+		// Stack words only move slots, the depth is known here
+		if (instruction.opcode == RPNProgram::OP_DUP || instruction.opcode == RPNProgram::OP_OVER)
+		{
+			size_t	from = (instruction.opcode == RPNProgram::OP_DUP) ? depth - 1 : depth - 2;
+			emitLoadSlot(emitter, RAX, from);
+			emitStoreSlot(emitter, depth, RAX);
+			depth++;
+			continue;
+		}
+		if (instruction.opcode == RPNProgram::OP_SWAP)
+		{
+			emitLoadSlot(emitter, RAX, depth - 1);
+			emitLoadSlot(emitter, RCX, depth - 2);
+			emitStoreSlot(emitter, depth - 2, RAX);
+			emitStoreSlot(emitter, depth - 1, RCX);
+			continue;
+		}
+		if (instruction.opcode == RPNProgram::OP_DROP)
+		{
+			depth--;
+			continue;
+		}
+		emitBinary(emitter, instruction.opcode, depth - 2);
+		depth--;
+	}
+
+	emitLoadSlot(emitter, RAX, 0);
+	emitByte(emitter, 0x48); // mov [rsi], rax
+	emitByte(emitter, 0x89);
+	emitByte(emitter, 0x06);
+	emitByte(emitter, 0xB8); // mov eax, 1
+	emitInt32(emitter, 1);
+
+	size_t	done = emitter.code.size();
+	emitByte(emitter, 0x48);
+	emitByte(emitter, 0x81);
+	emitByte(emitter, 0xC4);
+	emitInt32(emitter, static_cast<int>(emitter.frameSize));
+	for (int reg = 15; reg >= 12; reg--)
+	{
+		emitByte(emitter, 0x41);
+		emitByte(emitter, static_cast<unsigned char>(0x58 + (reg & 7)));
+	}
+	emitByte(emitter, 0xC3);
+
+	size_t	fail = emitter.code.size();
+	emitByte(emitter, 0x31); // xor eax, eax
+	emitByte(emitter, 0xC0);
+	emitByte(emitter, 0xE9); // jmp done
+	emitInt32(emitter, static_cast<int>(done) - static_cast<int>(emitter.code.size() + 4));
+
+	for (size_t i = 0; i < emitter.failJumps.size(); i++)
+	{
+		size_t	at = emitter.failJumps[i];
+		int		relative = static_cast<int>(fail) - static_cast<int>(at + 4);
+		std::memcpy(&emitter.code[at], &relative, 4);
+	}
+	return (true);
+}
@@ -0,0 +1,80 @@
+#ifndef RPNJIT_HPP
+# define RPNJIT_HPP
+
+#include "RPN.hpp"
+#include <vector>
+
+/*
+	Optional native backend for hot programs (x86-64 only).
+
+	compile() turns a validated RPNProgram into machine code in its own
+	mmap'd page (written, then switched to read+exec). The operand stack
+	is resolved at compile time:
+	- stack slots 0..7 live in r8..r15, deeper slots in the native frame
+	- the checks of safeAdd/safeSub/safeMul become a `jo` after the
+	  instruction, safeDiv becomes a test for 0 and for LONG_MIN / -1
+
+	"x 2 * y +"   ->   mov r8, [rdi + 8*23]
+	                   mov r9, 2
+	                   imul r8, r9 ; jo fail
+	                   mov r9, [rdi + 8*24]
+	                   add r8, r9 ; jo fail
+	                   mov [rsi], r8 ; return 1
+
+	DUP / SWAP / OVER are slot moves, DROP emits nothing.
+
+	SAVE / RECALL temps (optimised programs) are frame slots after the
+	deepest stack slot. The frame is reserved by one `sub rsp` without
+	stack probes, so it is kept to one page (512 slots).
+
+	run() falls back to the interpreter (RPN::evaluate) when there is no
+	native code: other architecture, mmap refused, a frame past one page
+	(deeper than 520 operands with its temps), or a malformed program
+	(which the interpreter then rejects exactly as usual).
+*/
+class	RPNJit
+{
+	public:
+		RPNJit();
+		~RPNJit();
+		RPNJit(const RPNJit &other);
+		RPNJit	&operator=(const RPNJit &other);
+
+		// false = no native code, run() will use the interpreter
+		bool	compile(const RPNProgram &program);
+		bool	isNative() const;
+		bool	run(const long *variables, long &output);
+
+	private:
+		typedef int	(*NativeFunction)(const long *variables, long *output);
+
+		RPNProgram		_program;
+		RPN				_interpreter;
+		void			*_page;
+		size_t			_pageSize;
+		NativeFunction	_function;
+
+		void	release();
+
+		// Code generation
+		struct Emitter
+		{
+			std::vector<unsigned char>	code;
+			std::vector<size_t>			failJumps; // rel32 offsets to patch
+			size_t						frameSize;
+		};
+		static void	emitByte(Emitter &emitter, unsigned char byte);
+		static void	emitInt32(Emitter &emitter, int value);
+		static void	emitInt64(Emitter &emitter, long value);
+		static void	emitMovRegReg(Emitter &emitter, int dst, int src);
+		static void	emitMovRegImm(Emitter &emitter, int reg, long value);
+		static void	emitLoadSlot(Emitter &emitter, int reg, size_t slot);
+		static void	emitStoreSlot(Emitter &emitter, size_t slot, int reg);
+		static void	emitLoadVariable(Emitter &emitter, int reg, long index);
+		static void	emitJumpToFail(Emitter &emitter, unsigned char condition);
+		static void	emitBinary(Emitter &emitter, RPNProgram::OpCode opcode, size_t lhsSlot);
+		static void	emitDivide(Emitter &emitter);
+		static bool	generate(const RPNProgram &program, size_t maxDepth, Emitter &emitter);
+};
+
+#endif
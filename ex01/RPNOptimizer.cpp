@@ -0,0 +1,320 @@
+#include "RPNOptimizer.hpp"
+#include <algorithm> // std::swap
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNOptimizer::RPNOptimizer():
+	_nodes(),
+	_index(),
+	_folder()
+{}
+
+RPNOptimizer::~RPNOptimizer()
+{}
+
+RPNOptimizer::RPNOptimizer(const RPNOptimizer &other):
+	_nodes(other._nodes),
+	_index(other._index),
+	_folder(other._folder)
+{}
+
+RPNOptimizer	&RPNOptimizer::operator=(const RPNOptimizer &other)
+{
+	if (this != &other)
+	{
+		this->_nodes = other._nodes;
+		this->_index = other._index;
+		this->_folder = other._folder;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+bool	RPNOptimizer::optimize(const RPNProgram &input, RPNProgram &output)
+{
+	std::vector<size_t>	roots;
+	if (buildGraph(input, roots) == false)
+	{
+		output = input;
+		reset();
+		return (false);
+	}
+	output.clear();
+	emit(roots, output);
+	output.requireVariables(input.variableCount());
+	reset();
+	return (true);
+}
+
+// =============================================================================
+// Expression Graph
+// =============================================================================
+
+bool	RPNOptimizer::Node::operator<(const Node &other) const
+{
+	if (kind != other.kind)
+		return (kind < other.kind);
+	if (kind != NODE_OPERATION)
+		return (value < other.value);
+	if (opcode != other.opcode)
+		return (opcode < other.opcode);
+	if (lhs != other.lhs)
+		return (lhs < other.lhs);
+	return (rhs < other.rhs);
+}
+
+void	RPNOptimizer::reset()
+{
+	_nodes.clear();
+	_index.clear();
+}
+
+// Same node twice -> same index: this is the common subexpression elimination
+size_t	RPNOptimizer::intern(const Node &node)
+{
+	std::map<Node, size_t>::iterator	it = _index.find(node);
+	if (it != _index.end())
+		return (it->second);
+	_nodes.push_back(node);
+	_index.insert(std::make_pair(node, _nodes.size() - 1));
+	return (_nodes.size() - 1);
+}
+
+size_t	RPNOptimizer::makeConstant(long value)
+{
+	Node	node;
+	node.kind = NODE_CONSTANT;
+	node.opcode = RPNProgram::OP_PUSH;
+	node.value = value;
+	node.lhs = 0;
+	node.rhs = 0;
+	return (intern(node));
+}
+
+size_t	RPNOptimizer::makeVariable(long index)
+{
+	Node	node;
+	node.kind = NODE_VARIABLE;
+	node.opcode = RPNProgram::OP_LOAD;
+	node.value = index;
+	node.lhs = 0;
+	node.rhs = 0;
+	return (intern(node));
+}
+
+/*
+	Folding and identities, then interning.
+	Never drops an operand that can fail: "x y * 0 *" keeps the
+	multiplication, which may overflow, so the program still fails.
+*/
+size_t	RPNOptimizer::makeOperation(RPNProgram::OpCode opcode, size_t lhs, size_t rhs)
+{
+	if (_nodes[lhs].kind == NODE_CONSTANT && _nodes[rhs].kind == NODE_CONSTANT)
+	{
+		long	folded = 0;
+		if (_folder.applyOpCode(_nodes[lhs].value, _nodes[rhs].value, opcode, folded))
+			return (makeConstant(folded));
+	}
+	switch (opcode)
+	{
+		case RPNProgram::OP_ADD:
+			if (isConstant(rhs, 0))
+				return (lhs);
+			if (isConstant(lhs, 0))
+				return (rhs);
+			break ;
+		case RPNProgram::OP_SUB:
+			if (isConstant(rhs, 0))
+				return (lhs);
+			if (lhs == rhs && !canFail(lhs))
+				return (makeConstant(0));
+			break ;
+		case RPNProgram::OP_MUL:
+			if (isConstant(rhs, 1))
+				return (lhs);
+			if (isConstant(lhs, 1))
+				return (rhs);
+			if ((isConstant(rhs, 0) && !canFail(lhs)) || (isConstant(lhs, 0) && !canFail(rhs)))
+				return (makeConstant(0));
+			break ;
+		case RPNProgram::OP_DIV:
+			if (isConstant(rhs, 1))
+				return (lhs);
+			break ;
+		default:
+			break ;
+	}
+
+	Node	node;
+	node.kind = NODE_OPERATION;
+	node.opcode = opcode;
+	node.value = 0;
+	node.lhs = lhs;
+	node.rhs = rhs;
+	if ((opcode == RPNProgram::OP_ADD || opcode == RPNProgram::OP_MUL) && rhs < lhs)
+	{
+		node.lhs = rhs; // commutative: one canonical order
+		node.rhs = lhs;
+	}
+	return (intern(node));
+}
+
+bool	RPNOptimizer::isConstant(size_t node, long value) const
+{
+	return (_nodes[node].kind == NODE_CONSTANT && _nodes[node].value == value);
+}
+
+// Constants and variables never fail, an operation left after folding may
+bool	RPNOptimizer::canFail(size_t node) const
+{
+	return (_nodes[node].kind == NODE_OPERATION);
+}
+
+/*
+	The evaluation loop of RPN::evaluate, with node indices on the stack.
+	Rejects what the interpreter would reject, and a RECALL of a temp
+	that was never saved.
+	roots = the dropped operations that may fail, then the result.
+*/
+bool	RPNOptimizer::buildGraph(const RPNProgram &input, std::vector<size_t> &roots)
+{
+	size_t	maxDepth = 0;
+	if (input.measureDepth(maxDepth) == false)
+		return (false);
+
+	reset();
+	std::vector<size_t>	stack;
+	std::vector<size_t>	temps(input.tempCount());
+	std::vector<bool>	saved(input.tempCount(), false);
+	stack.reserve(maxDepth);
+	for (size_t i = 0; i < input.size(); i++)
+	{
+		const RPNProgram::Instruction	&instruction = input[i];
+		switch (instruction.opcode)
+		{
+			case RPNProgram::OP_PUSH:
+				stack.push_back(makeConstant(instruction.operand));
+				break ;
+			case RPNProgram::OP_LOAD:
+				stack.push_back(makeVariable(instruction.operand));
+				break ;
+			case RPNProgram::OP_SAVE:
+				temps[instruction.operand] = stack.back();
+				saved[instruction.operand] = true;
+				break ;
+			case RPNProgram::OP_RECALL:
+				if (saved[instruction.operand] == false)
+					return (false);
+				stack.push_back(temps[instruction.operand]);
+				break ;
+			case RPNProgram::OP_DUP:
+				stack.push_back(stack.back());
+				break ;
+			case RPNProgram::OP_SWAP:
+				std::swap(stack[stack.size() - 1], stack[stack.size() - 2]);
+				break ;
+			case RPNProgram::OP_OVER:
+				stack.push_back(stack[stack.size() - 2]);
+				break ;
+			case RPNProgram::OP_DROP:
+				if (canFail(stack.back()))
+					roots.push_back(stack.back());
+				stack.pop_back();
+				break ;
+			default:
+			{
+				size_t	rhs = stack.back();
+				stack.pop_back();
+				size_t	lhs = stack.back();
+				stack.back() = makeOperation(instruction.opcode, lhs, rhs);
+			}
+		}
+	}
+	roots.push_back(stack.back());
+	return (true);
+}
+
+/*
+	Postorder walk from each root, without recursion (long chains).
+	uses[n] = number of references to n from the reachable graph:
+	an operation used more than once gets a temp.
+	Every root but the last is a dropped value: DROP after it.
+*/
+void	RPNOptimizer::emit(const std::vector<size_t> &roots, RPNProgram &output) const
+{
+	std::vector<size_t>	uses(_nodes.size(), 0);
+	std::vector<size_t>	pending;
+	for (size_t r = 0; r < roots.size(); r++)
+	{
+		if (uses[roots[r]]++ == 0)
+			pending.push_back(roots[r]);
+	}
+	while (!pending.empty())
+	{
+		size_t	node = pending.back();
+		pending.pop_back();
+		if (_nodes[node].kind != NODE_OPERATION)
+			continue ;
+		for (int side = 0; side < 2; side++)
+		{
+			size_t	child = (side == 0) ? _nodes[node].lhs : _nodes[node].rhs;
+			if (uses[child]++ == 0)
+				pending.push_back(child);
+		}
+	}
+
+	const size_t		NO_TEMP = static_cast<size_t>(-1);
+	std::vector<size_t>	temp(_nodes.size(), NO_TEMP);
+	size_t				tempCount = 0;
+	for (size_t r = 0; r < roots.size(); r++)
+	{
+		if (r > 0)
+			output.emit(RPNProgram::OP_DROP, 0);
+		emitTree(roots[r], uses, temp, tempCount, output);
+	}
+}
+
+void	RPNOptimizer::emitTree(size_t root, const std::vector<size_t> &uses,
+								std::vector<size_t> &temp, size_t &tempCount,
+								RPNProgram &output) const
+{
+	const size_t		NO_TEMP = static_cast<size_t>(-1);
+	std::vector<std::pair<size_t, int> >	walk(1, std::make_pair(root, 0));
+	while (!walk.empty())
+	{
+		size_t		node = walk.back().first;
+		int			&state = walk.back().second;
+		const Node	&current = _nodes[node];
+		if (current.kind == NODE_CONSTANT || current.kind == NODE_VARIABLE)
+		{
+			output.emit(current.opcode, current.value);
+			walk.pop_back();
+		}
+		else if (temp[node] != NO_TEMP)
+		{
+			output.emit(RPNProgram::OP_RECALL, static_cast<long>(temp[node]));
+			walk.pop_back();
+		}
+		else if (state < 2)
+		{
+			size_t	child = (state == 0) ? current.lhs : current.rhs;
+			state++;
+			walk.push_back(std::make_pair(child, 0)); // invalidates state
+		}
+		else
+		{
+			output.emit(current.opcode, 0);
+			if (uses[node] > 1)
+			{
+				temp[node] = tempCount++;
+				output.emit(RPNProgram::OP_SAVE, static_cast<long>(temp[node]));
+			}
+			walk.pop_back();
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef RPNOPTIMIZER_HPP
+# define RPNOPTIMIZER_HPP
+
+#include "RPN.hpp"
+#include "RPNProgram.hpp"
+#include <map>
+#include <vector>
+
+/*
+	Rewrites a valid RPNProgram into a shorter one with the same results
+	AND the same failures (overflow, division by zero) as RPN::evaluate.
+
+	The program is first turned into an expression DAG by running the
+	stack on nodes instead of values. Identical subtrees get the same
+	node (hash-consing), + and * operands are sorted so "x y +" and
+	"y x +" are the same node too.
+
+	While building it:
+	- constants are folded with RPN::applyOpCode, a fold that fails
+	  (overflow, / 0) is kept as an operation so it still fails at run time
+	- x 0 +, 0 x +, x 0 -, x 1 *, 1 x *, x 1 /  ->  x
+	- x 0 *, 0 x *, x x -  ->  0, only when x cannot fail (constant or
+	  variable): an operation that could overflow is never removed
+
+	Then the DAG is emitted back in postorder. A shared operation is
+	computed once, kept with SAVE and reused with RECALL.
+
+	Stack words (RPNWords) disappear in the DAG: DUP / OVER push a node
+	again, SWAP swaps two. A DROPped operation that could fail is still
+	emitted, followed by DROP, so it still fails; other drops vanish.
+		"x dup * y swap -"  ->  LOAD y, LOAD x, LOAD x, MUL, SUB
+		"3 x y * drop"      ->  LOAD x, LOAD y, MUL, DROP, PUSH 3
+
+	"x 1 * 2 3 + y * + x 2 3 + y * + *"   (17 instructions)
+		-> LOAD x, PUSH 5, LOAD y, MUL, ADD, SAVE 0, RECALL 0, MUL   (8)
+	"x y * 0 *"   unchanged, x * y may overflow
+	"9 9 * 0 /"   -> PUSH 81, PUSH 0, DIV   (still fails)
+*/
+class	RPNOptimizer
+{
+	public:
+		RPNOptimizer();
+		~RPNOptimizer();
+		RPNOptimizer(const RPNOptimizer &other);
+		RPNOptimizer	&operator=(const RPNOptimizer &other);
+
+		// false = malformed program, output is a copy of the input
+		bool	optimize(const RPNProgram &input, RPNProgram &output);
+
+	private:
+		enum NodeKind
+		{
+			NODE_CONSTANT,
+			NODE_VARIABLE,
+			NODE_OPERATION
+		};
+
+		struct Node
+		{
+			NodeKind			kind;
+			RPNProgram::OpCode	opcode;	// NODE_OPERATION only
+			long				value;	// constant or variable index
+			size_t				lhs;
+			size_t				rhs;
+
+			bool	operator<(const Node &other) const;
+		};
+
+		std::vector<Node>		_nodes;
+		std::map<Node, size_t>	_index; // node -> position in _nodes
+		RPN						_folder;
+
+		void	reset();
+		size_t	intern(const Node &node);
+		size_t	makeConstant(long value);
+		size_t	makeVariable(long index);
+		size_t	makeOperation(RPNProgram::OpCode opcode, size_t lhs, size_t rhs);
+		bool	isConstant(size_t node, long value) const;
+		bool	canFail(size_t node) const;
+		bool	buildGraph(const RPNProgram &input, std::vector<size_t> &roots);
+		void	emit(const std::vector<size_t> &roots, RPNProgram &output) const;
+		void	emitTree(size_t root, const std::vector<size_t> &uses,
+							std::vector<size_t> &temp, size_t &tempCount,
+							RPNProgram &output) const;
+};
+
+#endif
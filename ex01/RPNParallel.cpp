@@ -0,0 +1,420 @@
+#include "RPNParallel.hpp"
+#include <algorithm> // std::reverse
+#include <sched.h> // sched_yield
+#include <unistd.h> // sysconf
+
+#define PARALLEL_GRAIN 8192
+#define PARALLEL_MAX_NESTING 64 // spines split inside right operands, past that: sequential
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+/*
+	Default: one worker per online core
+*/
+RPNParallel::RPNParallel():
+	_workerCount(1),
+	_grain(PARALLEL_GRAIN),
+	_sequential(),
+	_program(0),
+	_variables(0),
+	_first(),
+	_workers(),
+	_failed(0),
+	_stop(0)
+{
+	long	cores = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cores > 1)
+		_workerCount = static_cast<size_t>(cores);
+}
+
+RPNParallel::RPNParallel(size_t workers):
+	_workerCount(workers == 0 ? 1 : workers),
+	_grain(PARALLEL_GRAIN),
+	_sequential(),
+	_program(0),
+	_variables(0),
+	_first(),
+	_workers(),
+	_failed(0),
+	_stop(0)
+{}
+
+RPNParallel::RPNParallel(size_t workers, size_t grain):
+	_workerCount(workers == 0 ? 1 : workers),
+	_grain(grain == 0 ? 1 : grain),
+	_sequential(),
+	_program(0),
+	_variables(0),
+	_first(),
+	_workers(),
+	_failed(0),
+	_stop(0)
+{}
+
+RPNParallel::~RPNParallel()
+{}
+
+// Only the configuration is copied, the pool exists during evaluate() only
+RPNParallel::RPNParallel(const RPNParallel &other):
+	_workerCount(other._workerCount),
+	_grain(other._grain),
+	_sequential(),
+	_program(0),
+	_variables(0),
+	_first(),
+	_workers(),
+	_failed(0),
+	_stop(0)
+{}
+
+RPNParallel	&RPNParallel::operator=(const RPNParallel &other)
+{
+	if (this != &other)
+	{
+		this->_workerCount = other._workerCount;
+		this->_grain = other._grain;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+/*
+	The calling thread is worker 0, the others only steal.
+	If a thread cannot be started, the remaining workers do its share.
+*/
+bool	RPNParallel::evaluate(const RPNProgram &program, const long *variables, long &output)
+{
+	size_t	maxDepth = 0;
+	if (program.measureDepth(maxDepth) == false)
+		return (false);
+	if (_workerCount < 2 || program.size() <= 2 * _grain || program.tempCount() > 0)
+		return (_sequential.evaluate(program, variables, output));
+	if (program.variableCount() > 0 && variables == 0)
+		return (false);
+
+	_program = &program;
+	if (measureSubtrees() == false)
+	{
+		_program = 0;
+		std::vector<size_t>().swap(_first);
+		return (_sequential.evaluate(program, variables, output));
+	}
+	_variables = variables;
+	_failed = 0;
+	_stop = 0;
+	for (size_t i = 0; i < _workerCount; i++)
+	{
+		Worker	*worker = new Worker;
+		worker->owner = this;
+		worker->index = i;
+		worker->stack.resize(maxDepth);
+		pthread_mutex_init(&worker->mutex, 0);
+		_workers.push_back(worker);
+	}
+	std::vector<bool>	started(_workerCount, false);
+	for (size_t i = 1; i < _workerCount; i++)
+	{
+		if (pthread_create(&_workers[i]->thread, 0, &workerRoutine, _workers[i]) == 0)
+			started[i] = true;
+	}
+
+	long	result = 0;
+	bool	success = evaluateSubtree(*_workers[0], program.size() - 1, 0, result);
+	_stop = 1;
+	__sync_synchronize();
+	for (size_t i = 0; i < _workerCount; i++)
+	{
+		if (started[i])
+			pthread_join(_workers[i]->thread, 0);
+	}
+	for (size_t i = 0; i < _workerCount; i++) // no thief left
+	{
+		pthread_mutex_destroy(&_workers[i]->mutex);
+		delete _workers[i];
+	}
+	_workers.clear();
+	std::vector<size_t>().swap(_first);
+	_program = 0;
+	_variables = 0;
+	if (success == false || _failed)
+		return (false);
+	output = result;
+	return (true);
+}
+
+// =============================================================================
+// Work-Stealing Pool
+// =============================================================================
+
+void	*RPNParallel::workerRoutine(void *arg)
+{
+	Worker		*worker = static_cast<Worker *>(arg);
+	RPNParallel	*owner = worker->owner;
+
+	while (owner->_stop == 0)
+	{
+		Task	*task = owner->take(*worker);
+		if (task != 0)
+			owner->run(*worker, task);
+		else
+			sched_yield();
+	}
+	return (0);
+}
+
+void	RPNParallel::push(Worker &worker, Task *task)
+{
+	pthread_mutex_lock(&worker.mutex);
+	worker.tasks.push_back(task);
+	pthread_mutex_unlock(&worker.mutex);
+}
+
+// Own newest task first (still in cache), else the oldest task of another worker
+RPNParallel::Task	*RPNParallel::take(Worker &worker)
+{
+	Task	*task = 0;
+	pthread_mutex_lock(&worker.mutex);
+	if (!worker.tasks.empty())
+	{
+		task = worker.tasks.back();
+		worker.tasks.pop_back();
+	}
+	pthread_mutex_unlock(&worker.mutex);
+	for (size_t i = 1; task == 0 && i < _workers.size(); i++)
+	{
+		Worker	&victim = *_workers[(worker.index + i) % _workers.size()];
+		pthread_mutex_lock(&victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+		}
+		pthread_mutex_unlock(&victim.mutex);
+	}
+	return (task);
+}
+
+void	RPNParallel::run(Worker &worker, Task *task)
+{
+	evaluateChunk(worker, *task->spine, task->chunk);
+	__sync_sub_and_fetch(task->pending, 1); // full barrier: the results are visible
+}
+
+// Never blocks: a worker waiting for its children runs any task it can get
+void	RPNParallel::wait(Worker &worker, volatile long *pending)
+{
+	while (__sync_fetch_and_add(pending, 0) > 0)
+	{
+		Task	*task = take(worker);
+		if (task != 0)
+			run(worker, task);
+		else
+			sched_yield();
+	}
+}
+
+void	RPNParallel::fail()
+{
+	_failed = 1;
+	__sync_synchronize();
+}
+
+// =============================================================================
+// Tree Decomposition
+// =============================================================================
+
+bool	RPNParallel::isOperator(RPNProgram::OpCode opcode)
+{
+	return (opcode == RPNProgram::OP_ADD || opcode == RPNProgram::OP_SUB
+		|| opcode == RPNProgram::OP_MUL || opcode == RPNProgram::OP_DIV);
+}
+
+/*
+	One pass with a stack of subtree starts: an operand starts its own
+	subtree, an operator pops its right operand's start and keeps the
+	left one, which is where its own subtree starts.
+	false = not a tree (stack words): no contiguous subtrees to split.
+*/
+bool	RPNParallel::measureSubtrees()
+{
+	const RPNProgram	&program = *_program;
+	std::vector<size_t>	starts;
+	_first.resize(program.size());
+	for (size_t i = 0; i < program.size(); i++)
+	{
+		RPNProgram::OpCode	opcode = program[i].opcode;
+		if (isOperator(opcode))
+		{
+			starts.pop_back();
+			_first[i] = starts.back();
+		}
+		else if (opcode == RPNProgram::OP_PUSH || opcode == RPNProgram::OP_LOAD)
+		{
+			_first[i] = i;
+			starts.push_back(i);
+		}
+		else
+			return (false);
+	}
+	return (true);
+}
+
+/*
+	Small subtree: one sequential run over its instructions.
+	Big one: spine chunks go to the pool, the bottom operand is computed
+	here meanwhile, then the spine is folded.
+
+	A right operand is split again inside its chunk, one native frame
+	per level: a right-leaning chain ("1 1 ... 1 + + ... +") has a
+	one-node spine at every level, so past PARALLEL_MAX_NESTING levels
+	the subtree runs sequentially (evaluateRange keeps its stack on the
+	heap) instead of overflowing the thread's stack.
+*/
+bool	RPNParallel::evaluateSubtree(Worker &worker, size_t node, size_t nesting, long &result)
+{
+	if (_failed)
+		return (false);
+	const RPNProgram	&program = *_program;
+	if (!isOperator(program[node].opcode) || node - _first[node] + 1 <= _grain
+		|| nesting >= PARALLEL_MAX_NESTING)
+		return (evaluateRange(worker, _first[node], node, result));
+
+	Spine	spine;
+	spine.nesting = nesting;
+	size_t	bottom = node;
+	while (isOperator(program[bottom].opcode) && bottom - _first[bottom] + 1 > _grain)
+	{
+		spine.nodes.push_back(bottom);
+		bottom = _first[bottom - 1] - 1; // lhs
+	}
+	std::reverse(spine.nodes.begin(), spine.nodes.end());
+	spine.operands.resize(spine.nodes.size());
+
+	size_t	span = 0;
+	spine.chunkBegin.push_back(0);
+	for (size_t k = 0; k < spine.nodes.size(); k++)
+	{
+		size_t	rhs = spine.nodes[k] - 1;
+		span += rhs - _first[rhs] + 2; // operand + the operator
+		if (span >= _grain && k + 1 < spine.nodes.size())
+		{
+			spine.chunkBegin.push_back(k + 1);
+			span = 0;
+		}
+	}
+	spine.chunkBegin.push_back(spine.nodes.size());
+	size_t	chunks = spine.chunkBegin.size() - 1;
+	spine.prefixes.resize(chunks);
+
+	std::vector<Task>	tasks(chunks);
+	volatile long		pending = static_cast<long>(chunks);
+	for (size_t c = 0; c < chunks; c++)
+	{
+		tasks[c].spine = &spine;
+		tasks[c].chunk = c;
+		tasks[c].pending = &pending;
+		push(worker, &tasks[c]);
+	}
+	long	bottomValue = 0;
+	bool	success = evaluateSubtree(worker, bottom, nesting, bottomValue);
+	if (success == false)
+		fail();
+	wait(worker, &pending);
+	if (success == false || _failed)
+		return (false);
+	return (fold(spine, bottomValue, result));
+}
+
+// The instructions [first, last] form one subtree: plain checked evaluation
+bool	RPNParallel::evaluateRange(Worker &worker, size_t first, size_t last, long &result)
+{
+	const RPNProgram	&program = *_program;
+	long				*stack = &worker.stack[0];
+	size_t				depth = 0;
+	for (size_t i = first; i <= last; i++)
+	{
+		const RPNProgram::Instruction	&instruction = program[i];
+		if (instruction.opcode == RPNProgram::OP_PUSH)
+			stack[depth++] = instruction.operand;
+		else if (instruction.opcode == RPNProgram::OP_LOAD)
+			stack[depth++] = _variables[instruction.operand];
+		else
+		{
+			long	rhs = stack[--depth];
+			long	&lhs = stack[depth - 1];
+			if (_sequential.applyOpCode(lhs, rhs, instruction.opcode, lhs) == false)
+				return (false);
+		}
+	}
+	result = stack[0];
+	return (true);
+}
+
+/*
+	Right operands of the chunk, then its reduction if it is only + / -:
+	prefix k = sum of +operand / -operand up to k, exact in 128 bits.
+*/
+void	RPNParallel::evaluateChunk(Worker &worker, Spine &spine, size_t chunk)
+{
+	size_t	begin = spine.chunkBegin[chunk];
+	size_t	end = spine.chunkBegin[chunk + 1];
+	for (size_t k = begin; k < end; k++)
+	{
+		if (evaluateSubtree(worker, spine.nodes[k] - 1, spine.nesting + 1, spine.operands[k]) == false)
+		{
+			fail();
+			return ;
+		}
+	}
+
+	Prefix	&prefix = spine.prefixes[chunk];
+	prefix.additive = true;
+	prefix.sum = 0;
+	for (size_t k = begin; k < end && prefix.additive; k++)
+	{
+		RPNProgram::OpCode	opcode = (*_program)[spine.nodes[k]].opcode;
+		if (opcode == RPNProgram::OP_ADD)
+			prefix.sum += spine.operands[k];
+		else if (opcode == RPNProgram::OP_SUB)
+			prefix.sum -= spine.operands[k];
+		else
+			prefix.additive = false;
+		if (k == begin || prefix.sum < prefix.min)
+			prefix.min = prefix.sum;
+		if (k == begin || prefix.sum > prefix.max)
+			prefix.max = prefix.sum;
+	}
+}
+
+/*
+	bottom op1 r1 op2 r2 ... with the sequential rules:
+	a +/- chunk fits iff its lowest and highest running value fit.
+*/
+bool	RPNParallel::fold(const Spine &spine, long bottom, long &result) const
+{
+	long	accumulator = bottom;
+	for (size_t c = 0; c + 1 < spine.chunkBegin.size(); c++)
+	{
+		const Prefix	&prefix = spine.prefixes[c];
+		if (prefix.additive)
+		{
+			if (accumulator + prefix.min < LONG_MIN || accumulator + prefix.max > LONG_MAX)
+				return (false);
+			accumulator = static_cast<long>(accumulator + prefix.sum);
+			continue;
+		}
+		for (size_t k = spine.chunkBegin[c]; k < spine.chunkBegin[c + 1]; k++)
+		{
+			RPNProgram::OpCode	opcode = (*_program)[spine.nodes[k]].opcode;
+			if (_sequential.applyOpCode(accumulator, spine.operands[k], opcode, accumulator) == false)
+				return (false);
+		}
+	}
+	result = accumulator;
+	return (true);
+}
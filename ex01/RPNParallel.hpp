@@ -0,0 +1,122 @@
+#ifndef RPNPARALLEL_HPP
+# define RPNPARALLEL_HPP
+
+#include "RPN.hpp"
+#include <deque>
+#include <vector>
+#include <pthread.h>
+
+/*
+	One huge expression on every core.
+
+	In postfix, every subtree is a contiguous run of instructions that
+	ends with its root. One pass gives first[i], the first instruction of
+	the subtree rooted at i:
+		"1 2 + 3 4 * -"   first = 0 1 0 3 4 3 0
+		operator i : rhs = i - 1, lhs = first[i - 1] - 1
+
+	A subtree bigger than the grain (PARALLEL_GRAIN instructions by
+	default) is split along its left spine:
+		(((bottom op1 r1) op2 r2) op3 r3)  ->  bottom, r1, r2, r3 in parallel
+	then folded bottom-up. The spine is how long generated chains are
+	written ("a b + c + d + ..."), the right operands are the independent
+	subtrees. They are cut into chunks of about one grain, one task per
+	chunk, and a big operand is split again inside its task (fork-join on
+	a work-stealing pool: each worker pops its own tasks LIFO, an idle
+	worker steals the oldest task of another, a waiting task runs other
+	tasks instead of blocking).
+
+	Folding keeps the sequential rules (CheckedArithmetic, i.e. safe*):
+	- a chunk of only + and - is reduced inside its task as a parallel
+	  reduction: exact 128 bit sum and min / max of its running prefix.
+	  The fold then checks acc + min and acc + max against LONG_MIN /
+	  LONG_MAX, which is exactly "every intermediate result fits".
+	- * and / chunks are folded operand by operand with the checked
+	  operations (their operands were still computed in parallel).
+	Every operation of the program runs exactly once, so the program
+	fails here if and only if it fails in RPN::evaluate.
+
+	A right operand is split again at most PARALLEL_MAX_NESTING levels
+	deep (one native frame per level), deeper subtrees run sequentially.
+
+	Small programs, optimised programs and stack words (SAVE / RECALL,
+	DUP ... are not a tree) and a single worker just use RPN::evaluate.
+*/
+class	RPNParallel
+{
+	public:
+		RPNParallel();
+		explicit RPNParallel(size_t workers);
+		RPNParallel(size_t workers, size_t grain);
+		~RPNParallel();
+		RPNParallel(const RPNParallel &other);
+		RPNParallel	&operator=(const RPNParallel &other);
+
+		bool	evaluate(const RPNProgram &program, const long *variables, long &output);
+
+	private:
+		struct Spine;
+
+		// Right operands of one spine chunk, and its +/- reduction
+		struct Task
+		{
+			Spine			*spine;
+			size_t			chunk;
+			volatile long	*pending;	// decremented when done
+		};
+
+		// Running prefix of a +/- chunk: exact, relative to the chunk start
+		struct Prefix
+		{
+			bool		additive;
+			__int128	sum;
+			__int128	min;
+			__int128	max;
+		};
+
+		struct Spine
+		{
+			std::vector<size_t>	nodes;			// spine operators, bottom first
+			std::vector<long>	operands;		// right operand of each node
+			std::vector<size_t>	chunkBegin;		// chunk c = [chunkBegin[c], chunkBegin[c + 1])
+			std::vector<Prefix>	prefixes;		// one per chunk
+			size_t				nesting;		// spines above this one
+		};
+
+		struct Worker
+		{
+			RPNParallel			*owner;
+			size_t				index;
+			pthread_t			thread;
+			pthread_mutex_t		mutex;
+			std::deque<Task *>	tasks;
+			std::vector<long>	stack;
+		};
+
+		size_t					_workerCount;
+		size_t					_grain;	// instructions below which a subtree is not split
+		RPN						_sequential;
+		// State of the current evaluate(), shared by the workers
+		const RPNProgram		*_program;
+		const long				*_variables;
+		std::vector<size_t>		_first;
+		std::vector<Worker *>	_workers;
+		volatile int			_failed;
+		volatile int			_stop;
+
+		static void	*workerRoutine(void *arg);
+		void		push(Worker &worker, Task *task);
+		Task		*take(Worker &worker);
+		void		run(Worker &worker, Task *task);
+		void		wait(Worker &worker, volatile long *pending);
+		void		fail();
+
+		static bool	isOperator(RPNProgram::OpCode opcode);
+		bool		measureSubtrees();
+		bool		evaluateSubtree(Worker &worker, size_t node, size_t nesting, long &result);
+		bool		evaluateRange(Worker &worker, size_t first, size_t last, long &result);
+		void		evaluateChunk(Worker &worker, Spine &spine, size_t chunk);
+		bool		fold(const Spine &spine, long bottom, long &result) const;
+};
+
+#endif
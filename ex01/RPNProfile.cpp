@@ -0,0 +1,200 @@
+#include "RPNProfile.hpp"
+#include <iomanip> // std::setw
+#include <time.h> // clock_gettime
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNProfile::RPNProfile()
+{
+	reset();
+}
+
+RPNProfile::~RPNProfile()
+{}
+
+RPNProfile::RPNProfile(const RPNProfile &other)
+{
+	*this = other;
+}
+
+RPNProfile	&RPNProfile::operator=(const RPNProfile &other)
+{
+	if (this != &other)
+	{
+		this->_expressions = other._expressions;
+		for (size_t i = 0; i < OPERATOR_COUNT; i++)
+		{
+			this->_operations[i] = other._operations[i];
+			this->_nanoseconds[i] = other._nanoseconds[i];
+		}
+		this->_maxDepth = other._maxDepth;
+		for (size_t i = 0; i < REJECT_COUNT; i++)
+			this->_rejects[i] = other._rejects[i];
+	}
+	return (*this);
+}
+
+// =============================================================================
+// Hooks
+// =============================================================================
+
+bool	RPNProfile::enabled()
+{
+#ifdef RPN_PROFILE
+	return (true);
+#else
+	return (false);
+#endif
+}
+
+unsigned long long	RPNProfile::now()
+{
+	struct timespec	time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (static_cast<unsigned long long>(time.tv_sec) * 1000000000ULL
+		+ static_cast<unsigned long long>(time.tv_nsec));
+}
+
+void	RPNProfile::recordExpression()
+{
+	_expressions++;
+}
+
+void	RPNProfile::recordDepth(size_t depth)
+{
+	if (depth > _maxDepth)
+		_maxDepth = depth;
+}
+
+void	RPNProfile::recordReject(Reject reason)
+{
+	_rejects[reason]++;
+}
+
+// Token path: the operator character, already validated by the tokenizer
+void	RPNProfile::recordOperation(char op, long rhs, bool success, unsigned long long start)
+{
+	if (op == '+')
+		recordOperator(OPERATOR_ADD, rhs, success, start);
+	else if (op == '-')
+		recordOperator(OPERATOR_SUB, rhs, success, start);
+	else if (op == '*')
+		recordOperator(OPERATOR_MUL, rhs, success, start);
+	else
+		recordOperator(OPERATOR_DIV, rhs, success, start);
+}
+
+void	RPNProfile::recordOperation(RPNProgram::OpCode opcode, long rhs, bool success,
+									unsigned long long start)
+{
+	if (opcode == RPNProgram::OP_ADD)
+		recordOperator(OPERATOR_ADD, rhs, success, start);
+	else if (opcode == RPNProgram::OP_SUB)
+		recordOperator(OPERATOR_SUB, rhs, success, start);
+	else if (opcode == RPNProgram::OP_MUL)
+		recordOperator(OPERATOR_MUL, rhs, success, start);
+	else
+		recordOperator(OPERATOR_DIV, rhs, success, start);
+}
+
+// A failed / is a division by zero when rhs is 0, every other failure is an overflow
+void	RPNProfile::recordOperator(Operator op, long rhs, bool success, unsigned long long start)
+{
+	_nanoseconds[op] += now() - start;
+	_operations[op]++;
+	if (success)
+		return ;
+	if (op == OPERATOR_DIV && rhs == 0)
+		_rejects[REJECT_DIVISION_BY_ZERO]++;
+	else
+		_rejects[REJECT_OVERFLOW]++;
+}
+
+void	RPNProfile::merge(const RPNProfile &other)
+{
+	_expressions += other._expressions;
+	for (size_t i = 0; i < OPERATOR_COUNT; i++)
+	{
+		_operations[i] += other._operations[i];
+		_nanoseconds[i] += other._nanoseconds[i];
+	}
+	recordDepth(other._maxDepth);
+	for (size_t i = 0; i < REJECT_COUNT; i++)
+		_rejects[i] += other._rejects[i];
+}
+
+// =============================================================================
+// Results
+// =============================================================================
+
+void	RPNProfile::reset()
+{
+	_expressions = 0;
+	for (size_t i = 0; i < OPERATOR_COUNT; i++)
+	{
+		_operations[i] = 0;
+		_nanoseconds[i] = 0;
+	}
+	_maxDepth = 0;
+	for (size_t i = 0; i < REJECT_COUNT; i++)
+		_rejects[i] = 0;
+}
+
+unsigned long	RPNProfile::expressions() const
+{
+	return (_expressions);
+}
+
+unsigned long	RPNProfile::operations(Operator op) const
+{
+	return (_operations[op]);
+}
+
+unsigned long long	RPNProfile::nanoseconds(Operator op) const
+{
+	return (_nanoseconds[op]);
+}
+
+size_t	RPNProfile::maxDepth() const
+{
+	return (_maxDepth);
+}
+
+unsigned long	RPNProfile::rejects(Reject reason) const
+{
+	return (_rejects[reason]);
+}
+
+/*
+	expressions 4, max depth 3
+	op      count        ns   ns/op
+	+           2        84      42
+	...
+	rejected: invalid token 1, underflow 0, leftover 0, overflow 0, division by zero 1
+*/
+void	RPNProfile::report(std::ostream &output) const
+{
+	const char	*operators[OPERATOR_COUNT] = {"+", "-", "*", "/"};
+	const char	*reasons[REJECT_COUNT] = {"invalid token", "underflow", "leftover",
+											"overflow", "division by zero"};
+
+	output << "expressions " << _expressions << ", max depth " << _maxDepth << std::endl;
+	output << "op" << std::setw(9) << "count" << std::setw(10) << "ns"
+			<< std::setw(8) << "ns/op" << std::endl;
+	for (size_t i = 0; i < OPERATOR_COUNT; i++)
+	{
+		output << operators[i] << std::setw(10) << _operations[i]
+				<< std::setw(10) << _nanoseconds[i] << std::setw(8);
+		if (_operations[i] > 0)
+			output << _nanoseconds[i] / _operations[i];
+		else
+			output << "-";
+		output << std::endl;
+	}
+	output << "rejected:";
+	for (size_t i = 0; i < REJECT_COUNT; i++)
+		output << (i == 0 ? " " : ", ") << reasons[i] << " " << _rejects[i];
+	output << std::endl;
+}
@@ -0,0 +1,87 @@
+#ifndef RPNPROFILE_HPP
+# define RPNPROFILE_HPP
+
+#include "RPNProgram.hpp"
+#include <iostream>
+
+/*
+	Evaluation counters of one RPN object (RPN::profile()).
+
+	Only a build with -DRPN_PROFILE (make profile -> ./RPN_profile) records
+	anything: every hook in RPN is inside #ifdef RPN_PROFILE, so the normal
+	build has no clock read and no counter in its loops. The counters
+	then stay at zero.
+
+	Recorded by calculateExpression, calculateStream and evaluate():
+	- operations per operator and the time spent in them (safeAdd ..
+	  safeDiv, or the same checks of the compiled loop), in ns
+	- the deepest operand stack
+	- why expressions were rejected:
+		"3 a +"   invalid token
+		"3 +"     underflow
+		"3 4"     leftover operands (also the empty expression)
+		"9 ... *" overflow
+		"3 0 /"   division by zero
+
+	One clock read before and after each operation: a profiled run is
+	several times slower, the split between operators is what matters.
+*/
+class	RPNProfile
+{
+	public:
+		enum Operator
+		{
+			OPERATOR_ADD,
+			OPERATOR_SUB,
+			OPERATOR_MUL,
+			OPERATOR_DIV,
+			OPERATOR_COUNT
+		};
+
+		enum Reject
+		{
+			REJECT_INVALID_TOKEN,
+			REJECT_UNDERFLOW,
+			REJECT_LEFTOVER,
+			REJECT_OVERFLOW,
+			REJECT_DIVISION_BY_ZERO,
+			REJECT_COUNT
+		};
+
+		RPNProfile();
+		~RPNProfile();
+		RPNProfile(const RPNProfile &other);
+		RPNProfile	&operator=(const RPNProfile &other);
+
+		// true in a -DRPN_PROFILE build
+		static bool					enabled();
+		static unsigned long long	now(); // ns, monotonic
+
+		// Hooks
+		void	recordExpression();
+		void	recordDepth(size_t depth);
+		void	recordReject(Reject reason);
+		void	recordOperation(char op, long rhs, bool success, unsigned long long start);
+		void	recordOperation(RPNProgram::OpCode opcode, long rhs, bool success, unsigned long long start);
+		void	merge(const RPNProfile &other); // counters of a helper (RPNIncremental)
+
+		// Results
+		void				reset();
+		unsigned long		expressions() const;
+		unsigned long		operations(Operator op) const;
+		unsigned long long	nanoseconds(Operator op) const;
+		size_t				maxDepth() const;
+		unsigned long		rejects(Reject reason) const;
+		void				report(std::ostream &output) const;
+
+	private:
+		unsigned long		_expressions;
+		unsigned long		_operations[OPERATOR_COUNT];
+		unsigned long long	_nanoseconds[OPERATOR_COUNT];
+		size_t				_maxDepth;
+		unsigned long		_rejects[REJECT_COUNT];
+
+		void	recordOperator(Operator op, long rhs, bool success, unsigned long long start);
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "RPNProgram.hpp"
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNProgram::RPNProgram():
+	_code(),
+	_variableCount(0),
+	_tempCount(0),
+	_depth(0),
+	_maxDepth(0),
+	_underflow(false)
+{}
+
+RPNProgram::~RPNProgram()
+{}
+
+RPNProgram::RPNProgram(const RPNProgram &other):
+	_code(other._code),
+	_variableCount(other._variableCount),
+	_tempCount(other._tempCount),
+	_depth(other._depth),
+	_maxDepth(other._maxDepth),
+	_underflow(other._underflow)
+{}
+
+RPNProgram	&RPNProgram::operator=(const RPNProgram &other)
+{
+	if (this != &other)
+	{
+		this->_code = other._code;
+		this->_variableCount = other._variableCount;
+		this->_tempCount = other._tempCount;
+		this->_depth = other._depth;
+		this->_maxDepth = other._maxDepth;
+		this->_underflow = other._underflow;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// Builder
+// =============================================================================
+
+void	RPNProgram::clear()
+{
+	_code.clear();
+	_variableCount = 0;
+	_tempCount = 0;
+	_depth = 0;
+	_maxDepth = 0;
+	_underflow = false;
+}
+
+void	RPNProgram::emit(OpCode opcode, long operand)
+{
+	Instruction	instruction;
+	instruction.opcode = opcode;
+	instruction.operand = operand;
+	_code.push_back(instruction);
+	if (opcode == OP_LOAD && static_cast<size_t>(operand) + 1 > _variableCount)
+		_variableCount = static_cast<size_t>(operand) + 1;
+	if ((opcode == OP_SAVE || opcode == OP_RECALL)
+		&& static_cast<size_t>(operand) + 1 > _tempCount)
+		_tempCount = static_cast<size_t>(operand) + 1;
+	trackDepth(opcode);
+}
+
+// =============================================================================
+// Access
+// =============================================================================
+
+size_t	RPNProgram::size() const
+{
+	return (_code.size());
+}
+
+bool	RPNProgram::empty() const
+{
+	return (_code.empty());
+}
+
+size_t	RPNProgram::variableCount() const
+{
+	return (_variableCount);
+}
+
+void	RPNProgram::requireVariables(size_t count)
+{
+	if (count > _variableCount)
+		_variableCount = count;
+}
+
+size_t	RPNProgram::tempCount() const
+{
+	return (_tempCount);
+}
+
+const RPNProgram::Instruction	&RPNProgram::operator[](size_t index) const
+{
+	return (_code[index]);
+}
+
+// =============================================================================
+// Validation
+// =============================================================================
+
+/*
+	The stack effect is verified while the program is built, one step per
+	emit(), so checking a program before running it costs nothing:
+		"3 4 + +"  depth 1 2 1, then + with depth 1 -> underflow
+		"3 4"      depth 1 2, ends at 2             -> rejected
+*/
+void	RPNProgram::trackDepth(OpCode opcode)
+{
+	size_t	needed = 2; // operators, SWAP, OVER
+	if (opcode == OP_PUSH || opcode == OP_LOAD || opcode == OP_RECALL)
+		needed = 0;
+	else if (opcode == OP_SAVE || opcode == OP_DUP || opcode == OP_DROP)
+		needed = 1;
+	if (_depth < needed)
+	{
+		_underflow = true;
+		return ;
+	}
+	if (opcode == OP_PUSH || opcode == OP_LOAD || opcode == OP_RECALL
+		|| opcode == OP_DUP || opcode == OP_OVER)
+	{
+		_depth++;
+		if (_depth > _maxDepth)
+			_maxDepth = _depth;
+	}
+	else if (opcode != OP_SAVE && opcode != OP_SWAP)
+		_depth--; // operators, DROP
+}
+
+bool	RPNProgram::measureDepth(size_t &maxDepth) const
+{
+	maxDepth = _maxDepth;
+	return (_underflow == false && _depth == 1);
+}
+
+bool	RPNProgram::underflows() const
+{
+	return (_underflow);
+}
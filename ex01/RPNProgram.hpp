@@ -0,0 +1,83 @@
+#ifndef RPNPROGRAM_HPP
+# define RPNPROGRAM_HPP
+
+#include <vector>
+#include <cstddef>
+
+/*
+	Compiled RPN expression (see RPN::compile / RPN::evaluate)
+
+	"5 1 2 + 4 * + 3 -" becomes:
+		PUSH 5, PUSH 1, PUSH 2, ADD, PUSH 4, MUL, ADD, PUSH 3, SUB
+	"x 2 * y +" becomes:
+		LOAD 23, PUSH 2, MUL, LOAD 24, ADD   (variables a..z are 0..25)
+
+	SAVE / RECALL are only produced by RPNOptimizer, to compute a shared
+	subexpression once: "x y * x y * +" -> LOAD, LOAD, MUL, SAVE 0, RECALL 0, ADD
+
+	DUP / SWAP / OVER / DROP are the stack words of RPNWords:
+	": sq dup * ; x sq" -> LOAD 23, DUP, MUL
+
+	The text is tokenised and validated once, evaluating the program
+	is a plain loop over the instructions: no stream, no string.
+*/
+class	RPNProgram
+{
+	public:
+		RPNProgram();
+		~RPNProgram();
+		RPNProgram(const RPNProgram &other);
+		RPNProgram	&operator=(const RPNProgram &other);
+
+		enum OpCode
+		{
+			OP_PUSH,	// push operand
+			OP_LOAD,	// push variables[operand]
+			OP_ADD,
+			OP_SUB,
+			OP_MUL,
+			OP_DIV,
+			OP_SAVE,	// temps[operand] = top of the stack (not popped)
+			OP_RECALL,	// push temps[operand]
+			OP_DUP,		// a -> a a
+			OP_SWAP,	// a b -> b a
+			OP_OVER,	// a b -> a b a
+			OP_DROP		// a ->
+		};
+
+		struct Instruction
+		{
+			OpCode	opcode;
+			long	operand; // constant, variable index or temp index
+		};
+
+		// Builder
+		void	clear();
+		void	emit(OpCode opcode, long operand);
+		void	requireVariables(size_t count); // keeps "a 0 *" needing a once optimised
+
+		// Access
+		size_t				size() const;
+		bool				empty() const;
+		size_t				variableCount() const; // highest variable index + 1
+		size_t				tempCount() const; // highest temp index + 1
+		const Instruction	&operator[](size_t index) const;
+
+		// Stack rules of the interpreter, checked without running (O(1), kept by emit):
+		// an operator, SWAP and OVER need 2 operands, SAVE, DUP and DROP need 1,
+		// exactly 1 left at the end
+		bool				measureDepth(size_t &maxDepth) const;
+		bool				underflows() const; // why measureDepth failed, else values are left
+
+	private:
+		std::vector<Instruction>	_code;
+		size_t						_variableCount;
+		size_t						_tempCount;
+		size_t						_depth;		// stack depth after the last instruction
+		size_t						_maxDepth;
+		bool						_underflow;	// an instruction lacked operands
+
+		void	trackDepth(OpCode opcode);
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "RPNServer.hpp"
+#include <time.h> // clock_gettime
+
+#define SERVER_DEFAULT_CACHE 1024
+#define LATENCY_STEPS 32 // histogram buckets per power of two
+#define LATENCY_BUCKETS (LATENCY_STEPS + 59 * LATENCY_STEPS)
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNServer::RPNServer():
+	_rpn(),
+	_cache(SERVER_DEFAULT_CACHE),
+	_scratch(),
+	_latency(LATENCY_BUCKETS, 0),
+	_requests(0)
+{}
+
+RPNServer::RPNServer(size_t cacheSize):
+	_rpn(),
+	_cache(cacheSize),
+	_scratch(),
+	_latency(LATENCY_BUCKETS, 0),
+	_requests(0)
+{}
+
+RPNServer::~RPNServer()
+{}
+
+RPNServer::RPNServer(const RPNServer &other):
+	_rpn(other._rpn),
+	_cache(other._cache),
+	_scratch(),
+	_latency(other._latency),
+	_requests(other._requests)
+{}
+
+RPNServer	&RPNServer::operator=(const RPNServer &other)
+{
+	if (this != &other)
+	{
+		this->_rpn = other._rpn;
+		this->_cache = other._cache;
+		this->_latency = other._latency;
+		this->_requests = other._requests;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// Requests
+// =============================================================================
+
+size_t	RPNServer::run(std::istream &input, std::ostream &output)
+{
+	size_t		errors = 0;
+	std::string	line;
+	while (std::getline(input, line))
+	{
+		long	result = 0;
+		if (handle(line, result))
+			output << result << '\n';
+		else
+		{
+			output << "Error\n";
+			errors++;
+		}
+		if (input.rdbuf()->in_avail() <= 0) // the client waits for this answer
+			output.flush();
+	}
+	output.flush();
+	return (errors);
+}
+
+bool	RPNServer::handle(const std::string &expression, long &output)
+{
+	unsigned long long	start = now();
+	bool				compiled = false;
+	const RPNProgram	*program = _cache.find(expression, compiled);
+	if (program == 0)
+	{
+		compiled = _rpn.compile(expression, _scratch);
+		_cache.insert(expression, _scratch, compiled);
+		program = &_scratch;
+	}
+	bool	success = compiled && _rpn.evaluate(*program, output);
+	recordLatency(now() - start);
+	_requests++;
+	return (success);
+}
+
+// =============================================================================
+// Statistics
+// =============================================================================
+
+unsigned long	RPNServer::requests() const
+{
+	return (_requests);
+}
+
+double	RPNServer::hitRate() const
+{
+	unsigned long	lookups = _cache.hits() + _cache.misses();
+	if (lookups == 0)
+		return (0.0);
+	return (static_cast<double>(_cache.hits()) / lookups);
+}
+
+// Lower bound of the bucket holding the request at `percent`
+unsigned long long	RPNServer::latencyPercentile(double percent) const
+{
+	if (_requests == 0)
+		return (0);
+	unsigned long	rank = static_cast<unsigned long>(percent / 100.0 * _requests);
+	if (rank == 0)
+		rank = 1;
+	unsigned long	seen = 0;
+	for (size_t bucket = 0; bucket < _latency.size(); bucket++)
+	{
+		seen += _latency[bucket];
+		if (seen >= rank)
+			return (bucketValue(bucket));
+	}
+	return (bucketValue(_latency.size() - 1));
+}
+
+void	RPNServer::report(std::ostream &output) const
+{
+	output << "requests " << _requests
+			<< ", cache " << _cache.size() << "/" << _cache.capacity()
+			<< ", hit rate " << hitRate() * 100.0 << "%"
+			<< ", p50 " << latencyPercentile(50) << " ns"
+			<< ", p99 " << latencyPercentile(99) << " ns" << std::endl;
+}
+
+// =============================================================================
+// Latency Histogram
+// =============================================================================
+
+unsigned long long	RPNServer::now()
+{
+	struct timespec	time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (static_cast<unsigned long long>(time.tv_sec) * 1000000000ULL
+		+ static_cast<unsigned long long>(time.tv_nsec));
+}
+
+/*
+	Below 32 ns one bucket per ns, then 32 buckets per power of two:
+		v = 1xxxxx.... (e + 1 bits) -> the 5 bits after the leading one
+	v = 1000 -> e = 9, step 16: bucket of [992, 1008)
+*/
+size_t	RPNServer::bucketOf(unsigned long long nanoseconds)
+{
+	if (nanoseconds < LATENCY_STEPS)
+		return (static_cast<size_t>(nanoseconds));
+	size_t	exponent = 63 - __builtin_clzll(nanoseconds);
+	size_t	step = static_cast<size_t>(nanoseconds >> (exponent - 5)) - LATENCY_STEPS;
+	return (LATENCY_STEPS + (exponent - 5) * LATENCY_STEPS + step);
+}
+
+unsigned long long	RPNServer::bucketValue(size_t bucket)
+{
+	if (bucket < LATENCY_STEPS)
+		return (bucket);
+	size_t	exponent = (bucket - LATENCY_STEPS) / LATENCY_STEPS + 5;
+	size_t	step = (bucket - LATENCY_STEPS) % LATENCY_STEPS;
+	return (static_cast<unsigned long long>(LATENCY_STEPS + step) << (exponent - 5));
+}
+
+void	RPNServer::recordLatency(unsigned long long nanoseconds)
+{
+	_latency[bucketOf(nanoseconds)]++;
+}
@@ -0,0 +1,302 @@
+#include "RPNTokenizer.hpp"
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+# define TOKENIZER_LANE 32
+#elif defined(__SSE2__)
+# include <emmintrin.h>
+# define TOKENIZER_LANE 16
+#endif
+
+#define TOKENIZER_BLOCK 64 // bytes per set of masks, one bit each
+#define NO_BLOCK static_cast<size_t>(-1)
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNTokenizer::RPNTokenizer():
+	_data(0),
+	_size(0),
+	_pos(0),
+	_blockBase(NO_BLOCK),
+	_spaceMask(0),
+	_digitMask(0),
+	_operatorMask(0),
+	_letterMask(0)
+{}
+
+RPNTokenizer::RPNTokenizer(const char *data, size_t size):
+	_data(data),
+	_size(size),
+	_pos(0),
+	_blockBase(NO_BLOCK),
+	_spaceMask(0),
+	_digitMask(0),
+	_operatorMask(0),
+	_letterMask(0)
+{}
+
+RPNTokenizer::~RPNTokenizer()
+{}
+
+RPNTokenizer::RPNTokenizer(const RPNTokenizer &other):
+	_data(other._data),
+	_size(other._size),
+	_pos(other._pos),
+	_blockBase(other._blockBase),
+	_spaceMask(other._spaceMask),
+	_digitMask(other._digitMask),
+	_operatorMask(other._operatorMask),
+	_letterMask(other._letterMask)
+{}
+
+RPNTokenizer	&RPNTokenizer::operator=(const RPNTokenizer &other)
+{
+	if (this != &other)
+	{
+		this->_data = other._data;
+		this->_size = other._size;
+		this->_pos = other._pos;
+		this->_blockBase = other._blockBase;
+		this->_spaceMask = other._spaceMask;
+		this->_digitMask = other._digitMask;
+		this->_operatorMask = other._operatorMask;
+		this->_letterMask = other._letterMask;
+	}
+	return (*this);
+}
+
+// =============================================================================
+// Scanner
+// =============================================================================
+
+void	RPNTokenizer::reset(const char *data, size_t size)
+{
+	_data = data;
+	_size = size;
+	_pos = 0;
+	_blockBase = NO_BLOCK;
+}
+
+/*
+	skip whitespace -> token start -> run until whitespace/end -> classify
+
+	Only a one byte run can be valid, so the classification is done on the
+	first byte, then the run length decides: longer than 1 = invalid.
+*/
+void	RPNTokenizer::next(Token &token)
+{
+	_pos = skipRun(_pos, true);
+	token.offset = _pos;
+	token.value = 0;
+	if (_pos == _size)
+	{
+		token.kind = TOKEN_END;
+		token.length = 0;
+		return ;
+	}
+	size_t	start = _pos;
+	_pos = skipRun(_pos, false);
+	token.length = _pos - start;
+	classify(start, token);
+}
+
+// =============================================================================
+// Block Masks
+// =============================================================================
+
+#if defined(__AVX2__)
+
+// Bytes in [lo, hi]: the unsigned compare is a signed one after a 0x80 shift
+static __m256i	inRange(__m256i bytes, char lo, char hi)
+{
+	__m256i	shifted = _mm256_xor_si256(_mm256_sub_epi8(bytes, _mm256_set1_epi8(lo)),
+										_mm256_set1_epi8(static_cast<char>(0x80)));
+	return (_mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi - lo + 1 - 128)), shifted));
+}
+
+static unsigned long long	laneMask(__m256i matches)
+{
+	return (static_cast<unsigned int>(_mm256_movemask_epi8(matches)));
+}
+
+static void	classifyLane(const char *data, unsigned long long masks[4])
+{
+	__m256i	bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+	__m256i	space = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+									inRange(bytes, '\t', '\r'));
+	__m256i	op = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('+')),
+						_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('-'))),
+		_mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('*')),
+						_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('/'))));
+	masks[0] = laneMask(space);
+	masks[1] = laneMask(inRange(bytes, '0', '9'));
+	masks[2] = laneMask(op);
+	masks[3] = laneMask(inRange(bytes, 'a', 'z'));
+}
+
+#elif defined(__SSE2__)
+
+// Bytes in [lo, hi]: the unsigned compare is a signed one after a 0x80 shift
+static __m128i	inRange(__m128i bytes, char lo, char hi)
+{
+	__m128i	shifted = _mm_xor_si128(_mm_sub_epi8(bytes, _mm_set1_epi8(lo)),
+									_mm_set1_epi8(static_cast<char>(0x80)));
+	return (_mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(hi - lo + 1 - 128))));
+}
+
+static unsigned long long	laneMask(__m128i matches)
+{
+	return (static_cast<unsigned int>(_mm_movemask_epi8(matches)));
+}
+
+static void	classifyLane(const char *data, unsigned long long masks[4])
+{
+	__m128i	bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+	__m128i	space = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')),
+								inRange(bytes, '\t', '\r'));
+	__m128i	op = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('+')),
+					_mm_cmpeq_epi8(bytes, _mm_set1_epi8('-'))),
+		_mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('*')),
+					_mm_cmpeq_epi8(bytes, _mm_set1_epi8('/'))));
+	masks[0] = laneMask(space);
+	masks[1] = laneMask(inRange(bytes, '0', '9'));
+	masks[2] = laneMask(op);
+	masks[3] = laneMask(inRange(bytes, 'a', 'z'));
+}
+
+#endif
+
+// false = fewer than TOKENIZER_BLOCK bytes left (or no SIMD): use the byte loop
+bool	RPNTokenizer::loadBlock(size_t pos)
+{
+#if defined(TOKENIZER_LANE)
+	if (pos + TOKENIZER_BLOCK > _size)
+		return (false);
+	_spaceMask = 0;
+	_digitMask = 0;
+	_operatorMask = 0;
+	_letterMask = 0;
+	for (size_t lane = 0; lane < TOKENIZER_BLOCK; lane += TOKENIZER_LANE)
+	{
+		unsigned long long	masks[4];
+		classifyLane(_data + pos + lane, masks);
+		_spaceMask |= masks[0] << lane;
+		_digitMask |= masks[1] << lane;
+		_operatorMask |= masks[2] << lane;
+		_letterMask |= masks[3] << lane;
+	}
+	_blockBase = pos;
+	return (true);
+#else
+	(void)pos;
+	return (false);
+#endif
+}
+
+/*
+	First position from pos that is not whitespace (spaces = true), or
+	that is whitespace (spaces = false): the lowest stop bit of the block
+	at or after pos, else the next block.
+*/
+size_t	RPNTokenizer::skipRun(size_t pos, bool spaces)
+{
+	while (pos < _size)
+	{
+		bool	inBlock = _blockBase != NO_BLOCK && pos >= _blockBase
+							&& pos < _blockBase + TOKENIZER_BLOCK;
+		if (!inBlock && loadBlock(pos) == false)
+		{
+			while (pos < _size && isSpace(static_cast<unsigned char>(_data[pos])) == spaces)
+				pos++;
+			return (pos);
+		}
+		unsigned long long	stops = (spaces ? ~_spaceMask : _spaceMask) >> (pos - _blockBase);
+		if (stops != 0)
+			return (pos + __builtin_ctzll(stops));
+		pos = _blockBase + TOKENIZER_BLOCK;
+	}
+	return (pos);
+}
+
+// A one byte token still in the loaded block is read from the masks
+void	RPNTokenizer::classify(size_t start, Token &token) const
+{
+	char	first = _data[start];
+	if (token.length != 1)
+	{
+		token.kind = TOKEN_INVALID;
+		return ;
+	}
+	if (_blockBase != NO_BLOCK && start >= _blockBase && start < _blockBase + TOKENIZER_BLOCK)
+	{
+		unsigned long long	bit = 1ULL << (start - _blockBase);
+		if (_digitMask & bit)
+		{
+			token.kind = TOKEN_NUMBER;
+			token.value = first - '0';
+		}
+		else if (_operatorMask & bit)
+		{
+			token.kind = TOKEN_OPERATOR;
+			token.value = first;
+		}
+		else if (_letterMask & bit)
+		{
+			token.kind = TOKEN_VARIABLE;
+			token.value = first - 'a';
+		}
+		else
+			token.kind = TOKEN_INVALID;
+		return ;
+	}
+	if (first >= '0' && first <= '9')
+	{
+		token.kind = TOKEN_NUMBER;
+		token.value = first - '0';
+	}
+	else if (isOperatorChar(first))
+	{
+		token.kind = TOKEN_OPERATOR;
+		token.value = first;
+	}
+	else if (first >= 'a' && first <= 'z')
+	{
+		token.kind = TOKEN_VARIABLE;
+		token.value = first - 'a';
+	}
+	else
+		token.kind = TOKEN_INVALID;
+}
+
+// =============================================================================
+// Helper
+// =============================================================================
+
+/*
+	Same set as std::isspace in the "C" locale, without the locale lookup
+*/
+bool	RPNTokenizer::isSpace(unsigned char c)
+{
+	return (c == ' ' || (c >= '\t' && c <= '\r'));
+}
+
+bool	RPNTokenizer::isOperatorChar(char c)
+{
+	switch (c)
+	{
+		case '+':
+			return (true);
+		case '-':
+			return (true);
+		case '*':
+			return (true);
+		case '/':
+			return (true);
+		default:
+			return (false);
+	}
+}
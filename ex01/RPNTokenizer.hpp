@@ -0,0 +1,80 @@
+#ifndef RPNTOKENIZER_HPP
+# define RPNTOKENIZER_HPP
+
+#include <cstddef>
+
+/*
+	Single pass scanner over the raw bytes of an expression.
+
+	Same rules as `istringstream >> std::string` + the subject grammar:
+	- tokens are separated by whitespace (" \t\n\v\f\r", C locale isspace)
+	- a token is valid only if it is ONE byte: a digit or one of + - * /
+	- a lowercase letter ("x", "y") is TOKEN_VARIABLE, only RPN::compile
+	  accepts it, calculateExpression keeps the subject grammar
+	- anything else ("12", "A", "(1") is TOKEN_INVALID
+
+	No std::string and no stream: a token is (kind, value, offset) where
+	value is the digit (0..9) or the operator character.
+
+	"3 4 +" -> {NUMBER, 3, 0} {NUMBER, 4, 2} {OPERATOR, '+', 4} {END, 0, 5}
+
+	Long inputs are scanned 64 bytes at a time (SSE2: 4 x 16, AVX2: 2 x 32):
+	one pass over the block gives a bitmask per class, bit k = byte k
+		"3 4 + 12 x"   space    0 1 0 1 0 1 0 0 1 0
+		               digit    1 0 1 0 0 0 1 1 0 0
+		               operator 0 0 0 0 1 0 0 0 0 0
+		               letter   0 0 0 0 0 0 0 0 0 1
+	(invalid = none of them). Skipping whitespace and finding the end of
+	a token are then a count of trailing zeros on the space mask, and a
+	one byte token is classified by testing its bit. The last bytes
+	(< 64) and builds without SSE2 use the byte loop, same rules.
+*/
+class	RPNTokenizer
+{
+	public:
+		enum TokenKind
+		{
+			TOKEN_NUMBER,
+			TOKEN_OPERATOR,
+			TOKEN_VARIABLE,
+			TOKEN_INVALID,
+			TOKEN_END
+		};
+
+		struct Token
+		{
+			TokenKind	kind;
+			long		value;	// digit value, operator char or variable index (a = 0)
+			size_t		offset;	// first byte of the token in the input
+			size_t		length;	// number of bytes of the token
+		};
+
+		RPNTokenizer();
+		RPNTokenizer(const char *data, size_t size);
+		~RPNTokenizer();
+		RPNTokenizer(const RPNTokenizer &other);
+		RPNTokenizer	&operator=(const RPNTokenizer &other);
+
+		void	reset(const char *data, size_t size);
+		void	next(Token &token);
+
+		static bool	isSpace(unsigned char c);
+		static bool	isOperatorChar(char c);
+
+	private:
+		const char			*_data;
+		size_t				_size;
+		size_t				_pos;
+		// Class masks of the 64 bytes from _blockBase
+		size_t				_blockBase;	// NO_BLOCK: none loaded
+		unsigned long long	_spaceMask;
+		unsigned long long	_digitMask;
+		unsigned long long	_operatorMask;
+		unsigned long long	_letterMask;
+
+		bool	loadBlock(size_t pos);
+		size_t	skipRun(size_t pos, bool spaces);
+		void	classify(size_t start, Token &token) const;
+};
+
+#endif
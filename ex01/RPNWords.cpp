@@ -0,0 +1,184 @@
+#include "RPNWords.hpp"
+
+// =============================================================================
+// Ctors & Dtors & Copy Assignment Operator
+// =============================================================================
+
+RPNWords::RPNWords():
+	_macros()
+{}
+
+RPNWords::~RPNWords()
+{}
+
+RPNWords::RPNWords(const RPNWords &other):
+	_macros(other._macros)
+{}
+
+RPNWords	&RPNWords::operator=(const RPNWords &other)
+{
+	if (this != &other)
+		this->_macros = other._macros;
+	return (*this);
+}
+
+// =============================================================================
+// API
+// =============================================================================
+
+bool	RPNWords::compile(const std::string &expression, RPNProgram &program)
+{
+	return (compile(expression.data(), expression.size(), program));
+}
+
+/*
+	Three states: in the program, right after ':' (the name comes next),
+	inside a body (until ';'). Instructions go to `code` (the program) or
+	to `body` (the definition being read).
+*/
+bool	RPNWords::compile(const char *data, size_t size, RPNProgram &program)
+{
+	enum State
+	{
+		IN_PROGRAM,
+		AFTER_COLON,
+		IN_BODY
+	};
+
+	program.clear();
+	Code			code;
+	Code			body;
+	std::string		name;
+	State			state = IN_PROGRAM;
+	RPNTokenizer	tokenizer(data, size);
+	while (true)
+	{
+		RPNTokenizer::Token	token;
+		tokenizer.next(token);
+		if (token.kind == RPNTokenizer::TOKEN_END)
+			break;
+		std::string	word;
+		if (token.kind == RPNTokenizer::TOKEN_INVALID)
+			word.assign(data + token.offset, token.length);
+
+		if (state == AFTER_COLON)
+		{
+			if (isMacroName(word) == false)
+				return (false);
+			name = word;
+			body.clear();
+			state = IN_BODY;
+		}
+		else if (word == ":")
+		{
+			if (state != IN_PROGRAM)
+				return (false); // no definition inside a definition
+			state = AFTER_COLON;
+		}
+		else if (word == ";")
+		{
+			if (state != IN_BODY)
+				return (false);
+			_macros[name] = body;
+			state = IN_PROGRAM;
+		}
+		else if (appendToken(token, word, (state == IN_BODY) ? body : code) == false)
+			return (false);
+	}
+	if (state != IN_PROGRAM)
+		return (false); // definition never closed
+	for (size_t i = 0; i < code.size(); i++)
+		program.emit(code[i].opcode, code[i].operand);
+	return (true);
+}
+
+bool	RPNWords::isDefined(const std::string &name) const
+{
+	return (_macros.find(name) != _macros.end());
+}
+
+size_t	RPNWords::macroCount() const
+{
+	return (_macros.size());
+}
+
+void	RPNWords::clear()
+{
+	_macros.clear();
+}
+
+// =============================================================================
+// Words
+// =============================================================================
+
+bool	RPNWords::stackWord(const std::string &word, RPNProgram::OpCode &opcode)
+{
+	if (word == "dup")
+		opcode = RPNProgram::OP_DUP;
+	else if (word == "swap")
+		opcode = RPNProgram::OP_SWAP;
+	else if (word == "over")
+		opcode = RPNProgram::OP_OVER;
+	else if (word == "drop")
+		opcode = RPNProgram::OP_DROP;
+	else
+		return (false);
+	return (true);
+}
+
+bool	RPNWords::isMacroName(const std::string &word)
+{
+	RPNProgram::OpCode	opcode;
+	if (word.size() < 2 || word[0] < 'a' || word[0] > 'z' || stackWord(word, opcode))
+		return (false);
+	for (size_t i = 1; i < word.size(); i++)
+	{
+		char	c = word[i];
+		if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_'))
+			return (false);
+	}
+	return (true);
+}
+
+void	RPNWords::append(Code &code, RPNProgram::OpCode opcode, long operand)
+{
+	RPNProgram::Instruction	instruction;
+	instruction.opcode = opcode;
+	instruction.operand = operand;
+	code.push_back(instruction);
+}
+
+// One byte tokens as in RPN::compile, longer ones are stack words or macro calls
+bool	RPNWords::appendToken(const RPNTokenizer::Token &token, const std::string &word,
+								Code &code) const
+{
+	RPNProgram::OpCode	opcode;
+	if (code.size() >= RPN_WORDS_MAX_CODE)
+		return (false);
+	if (token.kind == RPNTokenizer::TOKEN_NUMBER)
+		append(code, RPNProgram::OP_PUSH, token.value);
+	else if (token.kind == RPNTokenizer::TOKEN_VARIABLE)
+		append(code, RPNProgram::OP_LOAD, token.value);
+	else if (token.kind == RPNTokenizer::TOKEN_OPERATOR)
+	{
+		if (token.value == '+')
+			append(code, RPNProgram::OP_ADD, 0);
+		else if (token.value == '-')
+			append(code, RPNProgram::OP_SUB, 0);
+		else if (token.value == '*')
+			append(code, RPNProgram::OP_MUL, 0);
+		else
+			append(code, RPNProgram::OP_DIV, 0);
+	}
+	else if (stackWord(word, opcode))
+		append(code, opcode, 0);
+	else
+	{
+		std::map<std::string, Code>::const_iterator	macro = _macros.find(word);
+		if (macro == _macros.end()
+			|| macro->second.size() > RPN_WORDS_MAX_CODE - code.size())
+			return (false);
+		code.insert(code.end(), macro->second.begin(), macro->second.end());
+	}
+	return (true);
+}
@@ -0,0 +1,75 @@
+#ifndef RPNWORDS_HPP
+# define RPNWORDS_HPP
+
+#include "RPNProgram.hpp"
+#include "RPNTokenizer.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+# ifndef RPN_WORDS_MAX_CODE
+#  define RPN_WORDS_MAX_CODE 1048576 // instructions, in a definition or a program
+# endif
+
+/*
+	Postfix with stack words and macros:
+		": sq dup * ; x sq y sq +"   ->   LOAD x, DUP, MUL, LOAD y, DUP, MUL, ADD
+
+	Words, on top of the RPN::compile tokens (digits, + - * /, a..z):
+		dup   a -> a a          swap  a b -> b a
+		over  a b -> a b a      drop  a ->
+		: name body ;           define a macro
+		name                    call it
+
+	A definition is compiled once, when its ';' is read: its body becomes
+	a list of instructions, where macros it calls are already expanded.
+	A call copies that list into the program, so a program using macros
+	is exactly the program of the expanded text: the evaluation loop never
+	sees a name, a call or a return.
+		": sq dup * ; : quad sq sq ;"   quad = DUP, MUL, DUP, MUL
+
+	Doubling a macro at each level grows the code exponentially
+	(": m1 1 ; : m2 m1 m1 ; : m3 m2 m2 ; ..."), so an expanded
+	definition or program past RPN_WORDS_MAX_CODE instructions is an
+	error, like an unknown word.
+
+	Macros are kept by the RPNWords object from one compile() to the next
+	(definitions made before an error too). Redefining a name only changes
+	the later calls, a macro cannot call itself (the name does not exist
+	before its ';').
+
+	A macro name is at least 2 characters (a..z are variables): a
+	lowercase letter, then lowercase letters, digits or '_', and not one
+	of the four stack words.
+
+	Only the words are checked here, the stack rules and the arithmetic
+	are checked by RPN::evaluate like for any other program.
+*/
+class	RPNWords
+{
+	public:
+		RPNWords();
+		~RPNWords();
+		RPNWords(const RPNWords &other);
+		RPNWords	&operator=(const RPNWords &other);
+
+		bool	compile(const std::string &expression, RPNProgram &program);
+		bool	compile(const char *data, size_t size, RPNProgram &program);
+
+		bool	isDefined(const std::string &name) const;
+		size_t	macroCount() const;
+		void	clear(); // forget every macro
+
+	private:
+		typedef std::vector<RPNProgram::Instruction>	Code;
+
+		std::map<std::string, Code>	_macros;
+
+		static bool	stackWord(const std::string &word, RPNProgram::OpCode &opcode);
+		static bool	isMacroName(const std::string &word);
+		static void	append(Code &code, RPNProgram::OpCode opcode, long operand);
+		bool		appendToken(const RPNTokenizer::Token &token, const std::string &word,
+								Code &code) const;
+};
+
+#endif
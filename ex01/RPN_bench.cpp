@@ -0,0 +1,571 @@
+#include "RPN.hpp"
+#include "RPNJit.hpp"
+#include "RPNOptimizer.hpp"
+#include "RPNParallel.hpp"
+#include <stack>
+#include <list>
+#include <sstream>
+#include <cstdlib>
+#include <new>
+#include <sys/time.h> // gettimeofday in microseconds
+#include <cstdio> // tmpfile
+#include <unistd.h> // lseek
+
+/*
+	Operand stack benchmark
+
+	make bench && ./RPN_bench
+
+	1. the RPN_test.sh cases must give the same results as before
+	2. allocations per token and time per token of the evaluation loop:
+	   - list  : the old std::stack<long, std::list<long> >
+	   - rpn   : RPN::evaluate on its contiguous OperandStack
+	3. big integer mode on deep multiplication chains:
+	   - chain : "9 9 * 9 * 9 * ..." (grows by one small factor per step)
+	   - tree  : "9 9 * 9 9 * * ..." (balanced, Karatsuba on the big products)
+	4. one formula over 1M rows: per row RPN::evaluate vs RPN::evaluateColumns
+	5. the same formula, 10M calls: RPN::evaluate vs RPNJit native code
+	6. a formula with identities and a repeated subtree, before and after
+	   RPNOptimizer
+	7. RPN::calculateStream over a 64 MB expression file, in GB/s
+	8. the formula of 5 in each arithmetic mode (RPN::evaluate with a mode)
+	9. one program of 2M instructions: RPN::evaluate vs RPNParallel
+	10. RPNTokenizer over a 16 MB expression: byte loop vs block masks
+*/
+
+// =============================================================================
+// Allocation counter (every operator new of this binary goes through here)
+// =============================================================================
+
+static size_t	g_allocations = 0;
+// Called through a pointer so the compiler cannot pair it with a new-expression
+static void		(*volatile g_release)(void *) = std::free;
+
+void	*operator new(size_t size) throw(std::bad_alloc)
+{
+	g_allocations++;
+	void	*ptr = std::malloc(size == 0 ? 1 : size);
+	if (ptr == 0)
+		throw std::bad_alloc();
+	return (ptr);
+}
+
+void	operator delete(void *ptr) throw()
+{
+	g_release(ptr);
+}
+
+void	*operator new[](size_t size) throw(std::bad_alloc)
+{
+	return (operator new(size));
+}
+
+void	operator delete[](void *ptr) throw()
+{
+	operator delete(ptr);
+}
+
+// =============================================================================
+// Helper
+// =============================================================================
+
+static double	currentTimeMicroseconds()
+{
+	struct	timeval	tv;
+	if (gettimeofday(&tv, 0) != 0)
+		return (0.0);
+	return (static_cast<double>(tv.tv_sec) * 1000000.0 + static_cast<double>(tv.tv_usec));
+}
+
+/*
+	Reference loop with the previous container (same stack checks,
+	plain arithmetic: the inputs below never overflow)
+*/
+static bool	evaluateWithList(const RPNProgram &program, long &output)
+{
+	std::stack<long, std::list<long> >	stack;
+	for (size_t i = 0; i < program.size(); i++)
+	{
+		const RPNProgram::Instruction	&instruction = program[i];
+		if (instruction.opcode == RPNProgram::OP_PUSH)
+		{
+			stack.push(instruction.operand);
+			continue;
+		}
+		if (stack.size() < 2)
+			return (false);
+		long	rhs = stack.top();
+		stack.pop();
+		long	lhs = stack.top();
+		stack.pop();
+		if (instruction.opcode == RPNProgram::OP_ADD)
+			stack.push(lhs + rhs);
+		else if (instruction.opcode == RPNProgram::OP_SUB)
+			stack.push(lhs - rhs);
+		else if (instruction.opcode == RPNProgram::OP_MUL)
+			stack.push(lhs * rhs);
+		else
+		{
+			if (rhs == 0)
+				return (false);
+			stack.push(lhs / rhs);
+		}
+	}
+	if (stack.size() != 1)
+		return (false);
+	output = stack.top();
+	return (true);
+}
+
+/*
+	"1 2 + 3 + 4 + ..." then a deep part "1 1 1 ... + + +" to go past
+	the inline capacity of the stack
+*/
+static std::string	makeLongExpression(size_t chain, size_t depth)
+{
+	std::string	expression = "1";
+	for (size_t i = 0; i < chain; i++)
+	{
+		expression += ' ';
+		expression += static_cast<char>('0' + (i % 10));
+		expression += (i % 2 == 0) ? " +" : " -";
+	}
+	for (size_t i = 0; i < depth; i++)
+		expression += " 1";
+	for (size_t i = 0; i < depth; i++)
+		expression += " +";
+	return (expression);
+}
+
+/*
+	Balanced product of 2^level nines
+	level 2: "9 9 * 9 9 * *"
+*/
+static void	makeProductTree(size_t level, std::string &expression)
+{
+	if (level == 0)
+	{
+		expression += "9 ";
+		return ;
+	}
+	makeProductTree(level - 1, expression);
+	makeProductTree(level - 1, expression);
+	expression += "* ";
+}
+
+// =============================================================================
+// Checks
+// =============================================================================
+
+static bool	checkTestCases(RPN &rpn)
+{
+	const char	*inputs[] = {
+		"8 1 +", "9 5 -", "7 6 *", "9 3 /", "2 3 + 4 +", "8 2 / 3 *",
+		"5 9 1 - *", "9 2 3 + /", "4 2 / 2 /", "3 3 * 2 - 4 /", "6 2 3 * +",
+		"5 9 + 8 7 - *", "8 5 2 * -", "9 1 - 8 2 / +", "7 3 - 2 2 + *",
+		"6 2 / 2 / 2 /", "8 0 /", "4 a +", "1 +", "2 2 2 +", "12 3 +",
+		"(1 2 +)", "9 0 0 / +", "0 7 7 - +"
+	};
+	const char	*outputs[] = {
+		"9", "4", "42", "3", "9", "12", "40", "1", "1", "1", "12", "14", "-2",
+		"12", "16", "0", "Error", "Error", "Error", "Error", "Error", "Error",
+		"Error", "0"
+	};
+	size_t	count = sizeof(inputs) / sizeof(inputs[0]);
+	size_t	failures = 0;
+
+	for (size_t i = 0; i < count; i++)
+	{
+		long				value = 0;
+		std::ostringstream	actual;
+		if (rpn.calculateExpression(inputs[i], value))
+			actual << value;
+		else
+			actual << "Error";
+		if (actual.str() != outputs[i])
+		{
+			std::cout << "FAIL \"" << inputs[i] << "\": expected " << outputs[i]
+						<< ", got " << actual.str() << std::endl;
+			failures++;
+		}
+	}
+	std::cout << "RPN_test.sh cases: " << (count - failures) << "/" << count << " ok" << std::endl;
+	return (failures == 0);
+}
+
+// =============================================================================
+// Benchmark
+// =============================================================================
+
+static bool	benchOperandStack(RPN &rpn)
+{
+	std::string	expression = makeLongExpression(2000, 100);
+	RPNProgram	program;
+	if (rpn.compile(expression, program) == false)
+		return (false);
+	const size_t	rounds = 2000;
+	const double	tokens = static_cast<double>(program.size()) * rounds;
+
+	long	listResult = 0;
+	long	rpnResult = 0;
+	bool	listOk = true;
+	bool	rpnOk = true;
+
+	rpn.evaluate(program, rpnResult); // warm-up: the stack reaches its peak depth once
+
+	size_t	a0 = g_allocations;
+	double	t0 = currentTimeMicroseconds();
+	for (size_t i = 0; i < rounds; i++)
+		listOk = evaluateWithList(program, listResult) && listOk;
+	double	t1 = currentTimeMicroseconds();
+	size_t	a1 = g_allocations;
+	for (size_t i = 0; i < rounds; i++)
+		rpnOk = rpn.evaluate(program, rpnResult) && rpnOk;
+	double	t2 = currentTimeMicroseconds();
+	size_t	a2 = g_allocations;
+
+	if (listOk != rpnOk || listResult != rpnResult)
+	{
+		std::cout << "FAIL: results differ (" << listResult << " / " << rpnResult << ")" << std::endl;
+		return (false);
+	}
+	std::cout.setf(std::ios::fixed);
+	std::cout.precision(3);
+	std::cout << "tokens per round  : " << program.size() << " (x" << rounds << ")" << std::endl;
+	std::cout << "list  : " << (a1 - a0) / tokens << " allocs/token, "
+				<< (t1 - t0) * 1000.0 / tokens << " ns/token" << std::endl;
+	std::cout << "rpn   : " << (a2 - a1) / tokens << " allocs/token, "
+				<< (t2 - t1) * 1000.0 / tokens << " ns/token" << std::endl;
+	return (true);
+}
+
+static bool	benchBigChain(const RPN &rpn, const std::string &label, const std::string &expression)
+{
+	BigInt	results;
+	double	t0 = currentTimeMicroseconds();
+	bool	ok = rpn.calculateExpressionBig(expression, results);
+	double	t1 = currentTimeMicroseconds();
+	if (ok == false)
+	{
+		std::cout << "FAIL: " << label << " gave Error" << std::endl;
+		return (false);
+	}
+	std::cout << label << " : " << results.toString().size() << " digits in "
+				<< (t1 - t0) / 1000.0 << " ms" << std::endl;
+	return (true);
+}
+
+static bool	benchBigInt(const RPN &rpn)
+{
+	std::string	chain = "9";
+	for (size_t i = 0; i < 5000; i++)
+		chain += " 9 *";
+	std::string	tree;
+	makeProductTree(13, tree);
+	return (benchBigChain(rpn, "big chain (5000 *)", chain)
+		&& benchBigChain(rpn, "big tree  (8191 *)", tree));
+}
+
+static bool	benchColumns(RPN &rpn)
+{
+	const size_t	rows = 1000000;
+	RPNProgram		program;
+	if (rpn.compile("x y * x + y 2 * - 3 /", program) == false)
+		return (false);
+	std::vector<long>	x(rows);
+	std::vector<long>	y(rows);
+	for (size_t i = 0; i < rows; i++)
+	{
+		x[i] = static_cast<long>(i) - 500000;
+		y[i] = static_cast<long>(i % 1000);
+	}
+	const long	*columns[26] = {0};
+	columns['x' - 'a'] = &x[0];
+	columns['y' - 'a'] = &y[0];
+
+	std::vector<long>			rowResults(rows);
+	std::vector<long>			columnResults(rows);
+	std::vector<unsigned char>	status(rows);
+	long						variables[26] = {0};
+
+	double	t0 = currentTimeMicroseconds();
+	for (size_t i = 0; i < rows; i++)
+	{
+		variables['x' - 'a'] = x[i];
+		variables['y' - 'a'] = y[i];
+		rpn.evaluate(program, variables, rowResults[i]);
+	}
+	double	t1 = currentTimeMicroseconds();
+	bool	ok = rpn.evaluateColumns(program, columns, rows, &columnResults[0], &status[0]);
+	double	t2 = currentTimeMicroseconds();
+	if (ok == false || rowResults != columnResults)
+	{
+		std::cout << "FAIL: column results differ" << std::endl;
+		return (false);
+	}
+	std::cout << "rows  : " << (t1 - t0) * 1000.0 / rows << " ns/row" << std::endl;
+	std::cout << "column: " << (t2 - t1) * 1000.0 / rows << " ns/row" << std::endl;
+	return (true);
+}
+
+static bool	benchJit(RPN &rpn)
+{
+	const size_t	calls = 10000000;
+	RPNProgram		program;
+	if (rpn.compile("x y * x + y 2 * - 3 /", program) == false)
+		return (false);
+	RPNJit	jit;
+	if (jit.compile(program) == false)
+		std::cout << "jit   : no native code here, interpreter fallback" << std::endl;
+
+	long	variables[26] = {0};
+	long	interpreted = 0;
+	long	native = 0;
+	long	result = 0;
+	double	t0 = currentTimeMicroseconds();
+	for (size_t i = 0; i < calls; i++)
+	{
+		variables['x' - 'a'] = static_cast<long>(i);
+		rpn.evaluate(program, variables, result);
+		interpreted += result;
+	}
+	double	t1 = currentTimeMicroseconds();
+	for (size_t i = 0; i < calls; i++)
+	{
+		variables['x' - 'a'] = static_cast<long>(i);
+		jit.run(variables, result);
+		native += result;
+	}
+	double	t2 = currentTimeMicroseconds();
+	if (interpreted != native)
+	{
+		std::cout << "FAIL: jit results differ" << std::endl;
+		return (false);
+	}
+	std::cout << "interp: " << (t1 - t0) * 1000.0 / calls << " ns/call" << std::endl;
+	std::cout << "jit   : " << (t2 - t1) * 1000.0 / calls << " ns/call" << std::endl;
+	return (true);
+}
+
+// A generated-looking formula: identities, constants and a repeated subtree
+static bool	benchOptimizer(RPN &rpn)
+{
+	const size_t	calls = 5000000;
+	RPNProgram		program;
+	RPNProgram		optimized;
+	RPNOptimizer	optimizer;
+	if (rpn.compile("x 1 * 2 3 + y * + 0 + x 2 3 + y * + 1 * * 4 4 * 2 / -", program) == false
+		|| optimizer.optimize(program, optimized) == false)
+		return (false);
+
+	long	variables[26] = {0};
+	long	plain = 0;
+	long	folded = 0;
+	long	result = 0;
+	double	t0 = currentTimeMicroseconds();
+	for (size_t i = 0; i < calls; i++)
+	{
+		variables['x' - 'a'] = static_cast<long>(i % 1000);
+		variables['y' - 'a'] = static_cast<long>(i % 7);
+		rpn.evaluate(program, variables, result);
+		plain += result;
+	}
+	double	t1 = currentTimeMicroseconds();
+	for (size_t i = 0; i < calls; i++)
+	{
+		variables['x' - 'a'] = static_cast<long>(i % 1000);
+		variables['y' - 'a'] = static_cast<long>(i % 7);
+		rpn.evaluate(optimized, variables, result);
+		folded += result;
+	}
+	double	t2 = currentTimeMicroseconds();
+	if (plain != folded)
+	{
+		std::cout << "FAIL: optimised results differ" << std::endl;
+		return (false);
+	}
+	std::cout << "instructions: " << program.size() << " -> " << optimized.size() << std::endl;
+	std::cout << "plain : " << (t1 - t0) * 1000.0 / calls << " ns/call" << std::endl;
+	std::cout << "folded: " << (t2 - t1) * 1000.0 / calls << " ns/call" << std::endl;
+	return (true);
+}
+
+// "1 2 + 1 - 2 + 1 - ..." : depth stays at 2, only the buffer is in memory
+static bool	benchStream(RPN &rpn)
+{
+	const size_t	pairs = 8 * 1024 * 1024;
+	std::FILE		*file = std::tmpfile();
+	if (file == 0)
+		return (false);
+	std::string	block;
+	for (size_t i = 0; i < 4096; i++)
+		block += "2 + 1 - ";
+	std::fputs("1 ", file);
+	for (size_t i = 0; i < pairs / 4096; i++)
+		std::fwrite(block.data(), 1, block.size(), file);
+	std::fflush(file);
+	lseek(fileno(file), 0, SEEK_SET);
+
+	long	result = 0;
+	size_t	bytes = 0;
+	double	t0 = currentTimeMicroseconds();
+	bool	ok = rpn.calculateStream(fileno(file), result, bytes);
+	double	t1 = currentTimeMicroseconds();
+	std::fclose(file);
+	if (ok == false || result != static_cast<long>(pairs) + 1)
+	{
+		std::cout << "FAIL: stream result " << result << std::endl;
+		return (false);
+	}
+	std::cout << "stream: " << bytes / (1024 * 1024) << " MB, "
+				<< bytes / (t1 - t0) / 1000.0 << " GB/s" << std::endl;
+	return (true);
+}
+
+static bool	benchModes(RPN &rpn)
+{
+	const size_t		calls = 10000000;
+	const char			*names[] = {"checked", "wrap", "saturate", "mod"};
+	RPN::ArithmeticMode	mode = RPN::MODE_CHECKED;
+	RPNProgram			program;
+	if (rpn.compile("x y * x + y 2 * - 3 /", program) == false)
+		return (false);
+
+	long	variables[26] = {0};
+	variables['y' - 'a'] = 7;
+	for (size_t m = 0; m < 4; m++)
+	{
+		RPN::parseArithmeticMode(names[m], mode);
+		long	sum = 0;
+		long	result = 0;
+		double	t0 = currentTimeMicroseconds();
+		for (size_t i = 0; i < calls; i++)
+		{
+			variables['x' - 'a'] = static_cast<long>(i);
+			if (rpn.evaluate(program, variables, result, mode) == false)
+				return (false);
+			sum += result;
+		}
+		double	t1 = currentTimeMicroseconds();
+		std::cout << names[m] << std::string(9 - std::string(names[m]).size(), ' ') << ": "
+					<< (t1 - t0) * 1000.0 / calls << " ns/call (checksum " << sum << ")" << std::endl;
+	}
+	return (true);
+}
+
+static bool	benchParallelCase(RPN &rpn, const std::string &label, const std::string &expression)
+{
+	RPNProgram	program;
+	if (rpn.compile(expression, program) == false)
+		return (false);
+	RPNParallel	parallel;
+	long		sequential = 0;
+	long		result = 0;
+	double		t0 = currentTimeMicroseconds();
+	bool		ok = rpn.evaluate(program, sequential);
+	double		t1 = currentTimeMicroseconds();
+	ok = parallel.evaluate(program, 0, result) && ok;
+	double		t2 = currentTimeMicroseconds();
+	if (ok == false || result != sequential)
+	{
+		std::cout << "FAIL: parallel " << label << " gives " << result
+					<< " instead of " << sequential << std::endl;
+		return (false);
+	}
+	std::cout << label << ": " << program.size() << " instructions, sequential "
+				<< (t1 - t0) / 1000.0 << " ms, parallel " << (t2 - t1) / 1000.0 << " ms" << std::endl;
+	return (true);
+}
+
+// One program of a few million instructions: a long spine and a balanced tree
+static bool	benchParallel(RPN &rpn)
+{
+	std::string	chain = "1";
+	for (size_t i = 0; i < 1000000; i++)
+		chain += (i % 2 == 0) ? " 9 +" : " 8 -";
+
+	std::string	tree = "1";
+	for (size_t level = 0; level < 20; level++)
+		tree = tree + " " + tree + " " + ((level % 2 == 0) ? "+" : "-");
+	std::cout << "cores : " << sysconf(_SC_NPROCESSORS_ONLN) << std::endl;
+	return (benchParallelCase(rpn, "chain", chain)
+		&& benchParallelCase(rpn, "tree ", tree));
+}
+
+// The byte loop RPNTokenizer::next had before the block masks, tokens only counted
+static size_t	countTokensByteLoop(const std::string &text)
+{
+	size_t	tokens = 0;
+	size_t	pos = 0;
+	while (true)
+	{
+		while (pos < text.size() && RPNTokenizer::isSpace(static_cast<unsigned char>(text[pos])))
+			pos++;
+		if (pos == text.size())
+			return (tokens);
+		size_t	start = pos;
+		while (pos < text.size() && !RPNTokenizer::isSpace(static_cast<unsigned char>(text[pos])))
+			pos++;
+		char	first = text[start];
+		if (pos - start == 1 && ((first >= '0' && first <= '9') || RPNTokenizer::isOperatorChar(first)))
+			tokens++;
+	}
+}
+
+static bool	benchTokenizer()
+{
+	std::string	text;
+	for (size_t i = 0; text.size() < 16 * 1024 * 1024; i++)
+	{
+		text += static_cast<char>('0' + i % 10);
+		text += (i % 7 == 0) ? "\t+   " : " - ";
+	}
+
+	double	t0 = currentTimeMicroseconds();
+	size_t	expected = countTokensByteLoop(text);
+	double	t1 = currentTimeMicroseconds();
+	RPNTokenizer		tokenizer(text.data(), text.size());
+	RPNTokenizer::Token	token;
+	size_t				tokens = 0;
+	for (tokenizer.next(token); token.kind != RPNTokenizer::TOKEN_END; tokenizer.next(token))
+	{
+		if (token.kind == RPNTokenizer::TOKEN_NUMBER || token.kind == RPNTokenizer::TOKEN_OPERATOR)
+			tokens++;
+	}
+	double	t2 = currentTimeMicroseconds();
+	if (tokens != expected)
+	{
+		std::cout << "FAIL: tokenizer counts " << tokens << " instead of " << expected << std::endl;
+		return (false);
+	}
+	std::cout << "tokens: " << tokens << " in " << text.size() / (1024 * 1024) << " MB" << std::endl;
+	std::cout << "byte loop: " << text.size() / (t1 - t0) / 1000.0 << " GB/s" << std::endl;
+	std::cout << "masks    : " << text.size() / (t2 - t1) / 1000.0 << " GB/s" << std::endl;
+	return (true);
+}
+
+int	main()
+{
+	RPN	rpn;
+	if (checkTestCases(rpn) == false)
+		return (1);
+	if (benchOperandStack(rpn) == false)
+		return (1);
+	if (benchBigInt(rpn) == false)
+		return (1);
+	if (benchColumns(rpn) == false)
+		return (1);
+	if (benchJit(rpn) == false)
+		return (1);
+	if (benchOptimizer(rpn) == false)
+		return (1);
+	if (benchStream(rpn) == false)
+		return (1);
+	if (benchModes(rpn) == false)
+		return (1);
+	if (benchParallel(rpn) == false)
+		return (1);
+	if (benchTokenizer() == false)
+		return (1);
+	return (0);
+}
@@ -0,0 +1,95 @@
+#include "RPN.hpp"
+#include "RPNConstexpr.hpp"
+
+/*
+	Compile-time evaluation check (C++14 build of the C++98 sources)
+
+	make constexpr
+
+	1. the RPN_test.sh cases, evaluated by the compiler (static_assert)
+	2. a table of expressions: RPNConstexpr at compile time vs
+	   RPN::calculateExpression at run time
+	3. every error kind must stop the compilation: the Makefile compiles
+	   this file again with -DRPN_CONSTEXPR_ERROR=1..6 and expects a failure
+*/
+
+// =============================================================================
+// 1. Subject cases
+// =============================================================================
+
+static_assert(RPN_CONSTANT("8 9 * 9 - 9 - 9 - 4 - 1 +") == 42, "subject example");
+static_assert(RPN_CONSTANT("7 7 * 7 -") == 42, "subject example");
+static_assert(RPN_CONSTANT("1 2 * 2 / 2 * 2 4 - +") == 0, "subject example");
+static_assert(RPN_CONSTANT("5 9 + 8 7 - *") == 14, "RPN_test.sh");
+static_assert(RPN_CONSTANT("8 5 2 * -") == -2, "RPN_test.sh");
+static_assert(RPN_CONSTANT("6 2 / 2 / 2 /") == 0, "RPN_test.sh");
+static_assert(RPN_CONSTANT(" \t3\n4 +\r") == 7, "every whitespace separates");
+static_assert(RPN_CONSTANT("0 9 - 9 /") == -1, "division truncates toward zero");
+
+// =============================================================================
+// 3. Errors (one per build)
+// =============================================================================
+
+#if RPN_CONSTEXPR_ERROR == 1
+static_assert(RPN_CONSTANT("4 a +") == 0, "invalid token");
+#elif RPN_CONSTEXPR_ERROR == 2
+static_assert(RPN_CONSTANT("12 3 +") == 0, "token longer than one byte");
+#elif RPN_CONSTEXPR_ERROR == 3
+static_assert(RPN_CONSTANT("1 +") == 0, "underflow");
+#elif RPN_CONSTEXPR_ERROR == 4
+static_assert(RPN_CONSTANT("2 2 2 +") == 0, "leftover operands");
+#elif RPN_CONSTEXPR_ERROR == 5
+static_assert(RPN_CONSTANT("8 0 /") == 0, "division by zero");
+#elif RPN_CONSTEXPR_ERROR == 6
+static_assert(RPN_CONSTANT("9 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 *") == 0,
+	"overflow");
+#endif
+
+// =============================================================================
+// 2. Compile time vs run time
+// =============================================================================
+
+struct	Case
+{
+	const char	*expression;
+	long		value; // computed by the compiler
+};
+
+# define CASE(expression) { expression, RPN_CONSTANT(expression) }
+
+static const Case	g_cases[] = {
+	CASE("8 1 +"),
+	CASE("9 5 -"),
+	CASE("3 3 * 2 - 4 /"),
+	CASE("9 1 - 8 2 / +"),
+	CASE("0 9 - 2 /"),
+	CASE("9 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 *"),
+	CASE("0 9 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * 9 * -"),
+	CASE("1 2 3 4 5 6 7 8 9 + + + + + + + +"),
+	CASE("9 8 7 6 5 4 3 2 1 - * - * - * - *"),
+	CASE("7 2 / 0 3 - /")
+};
+
+int	main()
+{
+	RPN		rpn;
+	size_t	failures = 0;
+	for (size_t i = 0; i < sizeof(g_cases) / sizeof(g_cases[0]); i++)
+	{
+		long	expected = 0;
+		if (rpn.calculateExpression(g_cases[i].expression, expected) == false
+			|| expected != g_cases[i].value)
+		{
+			std::cout << "FAIL \"" << g_cases[i].expression << "\" compile time "
+						<< g_cases[i].value << std::endl;
+			failures++;
+		}
+	}
+	if (failures > 0)
+	{
+		std::cout << failures << " mismatch(es)" << std::endl;
+		return (1);
+	}
+	std::cout << "constexpr: compile-time values match calculateExpression" << std::endl;
+	return (0);
+}
@@ -0,0 +1,962 @@
+#include "RPN.hpp"
+#include "RPNJit.hpp"
+#include "RPNOptimizer.hpp"
+#include "RPNInfix.hpp"
+#include "RPNIncremental.hpp"
+#include "RPNParallel.hpp"
+#include "RPNServer.hpp"
+#include "RPNWords.hpp"
+#include <cstdlib>
+#include <sstream>
+#include <cstdio> // tmpfile
+#include <unistd.h> // lseek
+
+/*
+	Differential test: every evaluation path must agree with
+	RPN::calculateExpression (or with RPN::evaluate once variables are in).
+
+	make test
+
+	1. random digit expressions, valid and invalid (depth, tokens, / 0)
+	   calculateExpression  vs  compile + evaluate  vs  RPNJit
+	2. random programs over x and y with extreme values (LONG_MIN, ...)
+	   RPN::evaluate  vs  RPNJit  (overflow and division checks)
+	3. programs with repeated subtrees, 0 and 1 (folding, identities, CSE)
+	   RPN::evaluate  vs  RPNOptimizer + evaluate / RPNJit / evaluateColumns
+	4. random trees written both ways, with the fewest parentheses
+	   RPNInfix must emit exactly the program of RPN::compile
+	5. random digit expressions read from a file, placed so that tokens
+	   straddle the 64 KiB read blocks
+	   calculateExpression  vs  calculateStream
+	6. random programs in every arithmetic mode
+	   RPN::evaluate(mode)  vs  a plain reference (unsigned / __int128 / %)
+	7. long chains and random trees, split with a tiny grain on 4 workers,
+	   and right-leaning chains of 100,000 and 2,000,000 operands
+	   RPN::evaluate  vs  RPNParallel (same overflow / division results)
+	8. a small pool of expressions requested in random order through a
+	   tiny cache (hits, evictions, invalid entries)
+	   calculateExpression  vs  RPNServer::handle
+	9. random bytes (every whitespace, digits, operators, letters, bytes
+	   >= 0x80) over several 64 byte blocks and a tail
+	   RPNTokenizer (block masks)  vs  a byte-at-a-time reference
+	10. random programs with dup / swap / over / drop, some underflowing
+	    reference (every mode)  vs  RPN::evaluate / RPNJit / RPNOptimizer /
+	    evaluateColumns / RPNParallel
+	    and macros: a text using them compiles to the program of the
+	    text with every call replaced by its body, until the expansion
+	    passes RPN_WORDS_MAX_CODE
+	11. random digit expressions cut at random points (empty pieces,
+	    single bytes, whole text) into one reused object
+	    calculateExpression  vs  RPNIncremental::feed + finish
+	12. "1 1 ... 1 + + ... +" around the JIT frame limit and far past
+	    it (2,000,000 operands): native code up to one page of spill
+	    slots, the interpreter beyond, same result
+	    calculateExpression  vs  RPNJit
+*/
+
+static const long	g_edgeValues[] = {
+	0, 1, -1, 2, -2, 7, -7, LONG_MAX, LONG_MIN, LONG_MAX - 1, LONG_MIN + 1,
+	3037000499L, -3037000499L, 4611686018427387904L, -4611686018427387904L
+};
+
+static long	randomValue()
+{
+	if (std::rand() % 2)
+		return (g_edgeValues[std::rand() % (sizeof(g_edgeValues) / sizeof(g_edgeValues[0]))]);
+	return (static_cast<long>(std::rand()) - RAND_MAX / 2);
+}
+
+/*
+	Mostly well formed: operands while the stack is short, operators after.
+	A few random tokens make some of them invalid.
+	`preload` operands first push the stack past the JIT register slots.
+*/
+static std::string	randomExpression(const char *operands, size_t operandCount,
+										bool noise, size_t preload)
+{
+	std::string	expression;
+	size_t		depth = preload;
+	size_t		length = preload + 1 + std::rand() % 40;
+	for (size_t i = 0; i < preload; i++)
+	{
+		expression += operands[std::rand() % operandCount];
+		expression += ' ';
+	}
+	for (size_t i = 0; i < length || depth > 1; i++)
+	{
+		if (i > 120)
+			break;
+		if (noise && std::rand() % 30 == 0)
+			expression += "+-*/a( 12"[std::rand() % 9];
+		else if (depth >= 2 && (std::rand() % 2 || i >= length))
+		{
+			expression += "+-*/"[std::rand() % 4];
+			depth--;
+		}
+		else
+		{
+			expression += operands[std::rand() % operandCount];
+			depth++;
+		}
+		expression += ' ';
+	}
+	return (expression);
+}
+
+static bool	sameOutcome(bool okA, long a, bool okB, long b)
+{
+	return (okA == okB && (!okA || a == b));
+}
+
+static size_t	checkDigitExpressions(size_t rounds)
+{
+	RPN		rpn;
+	size_t	failures = 0;
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	expression = randomExpression("0123456789", 10, true, 0);
+		long		expected = 0;
+		bool		expectedOk = rpn.calculateExpression(expression, expected);
+
+		RPNProgram	program;
+		long		compiled = 0;
+		bool		compiledOk = rpn.compile(expression, program) && rpn.evaluate(program, compiled);
+		RPNJit		jit;
+		long		native = 0;
+		bool		nativeOk = rpn.compile(expression, program) && jit.compile(program)
+								&& jit.run(0, native);
+		RPNOptimizer	optimizer;
+		RPNProgram		optimized;
+		long			folded = 0;
+		bool			foldedOk = rpn.compile(expression, program)
+									&& optimizer.optimize(program, optimized)
+									&& rpn.evaluate(optimized, folded);
+		if (!sameOutcome(expectedOk, expected, compiledOk, compiled)
+			|| !sameOutcome(expectedOk, expected, nativeOk, native)
+			|| !sameOutcome(expectedOk, expected, foldedOk, folded))
+		{
+			if (failures < 10)
+				std::cout << "FAIL \"" << expression << "\"" << std::endl;
+			failures++;
+		}
+	}
+	return (failures);
+}
+
+static size_t	checkVariablePrograms(size_t rounds)
+{
+	RPN		rpn;
+	size_t	failures = 0;
+	long	variables[26] = {0};
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	expression = randomExpression("0123456789xyxyxy", 16, false, (n % 4 == 0) ? 12 : 0);
+		RPNProgram	program;
+		if (rpn.compile(expression, program) == false)
+			continue;
+		RPNJit	jit;
+		jit.compile(program);
+		for (size_t row = 0; row < 20; row++)
+		{
+			variables['x' - 'a'] = randomValue();
+			variables['y' - 'a'] = randomValue();
+			long	expected = 0;
+			long	native = 0;
+			bool	expectedOk = rpn.evaluate(program, variables, expected);
+			bool	nativeOk = jit.run(variables, native);
+			if (!sameOutcome(expectedOk, expected, nativeOk, native))
+			{
+				if (failures < 10)
+					std::cout << "FAIL \"" << expression << "\" x=" << variables['x' - 'a']
+								<< " y=" << variables['y' - 'a'] << std::endl;
+				failures++;
+			}
+		}
+	}
+	return (failures);
+}
+
+/*
+	"E E op F op": E appears twice, so the optimiser has a shared
+	subtree to SAVE / RECALL, and 0 / 1 operands hit the identities.
+*/
+static size_t	checkOptimizedPrograms(size_t rounds)
+{
+	RPN				rpn;
+	RPNOptimizer	optimizer;
+	size_t			failures = 0;
+	long			x[20];
+	long			y[20];
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	shared = randomExpression("0112xyxy", 8, false, 0);
+		std::string	expression = shared + shared + "+-*/"[std::rand() % 4] + " "
+							+ randomExpression("01xy", 4, false, 0) + "+-*/"[std::rand() % 4];
+		RPNProgram	program;
+		RPNProgram	optimized;
+		if (rpn.compile(expression, program) == false
+			|| optimizer.optimize(program, optimized) == false)
+		{
+			std::cout << "FAIL (rejected) \"" << expression << "\"" << std::endl;
+			failures++;
+			continue;
+		}
+		RPNJit	jit;
+		jit.compile(optimized);
+
+		long			results[20];
+		unsigned char	status[20];
+		const long		*columns[26] = {0};
+		for (size_t row = 0; row < 20; row++)
+		{
+			x[row] = randomValue();
+			y[row] = randomValue();
+		}
+		columns['x' - 'a'] = x;
+		columns['y' - 'a'] = y;
+		rpn.evaluateColumns(optimized, columns, 20, results, status);
+		for (size_t row = 0; row < 20; row++)
+		{
+			long	variables[26] = {0};
+			variables['x' - 'a'] = x[row];
+			variables['y' - 'a'] = y[row];
+			long	expected = 0;
+			long	folded = 0;
+			long	native = 0;
+			bool	expectedOk = rpn.evaluate(program, variables, expected);
+			bool	foldedOk = rpn.evaluate(optimized, variables, folded);
+			bool	nativeOk = jit.run(variables, native);
+			bool	columnOk = (status[row] == ColumnKernels::ROW_OK);
+			if (!sameOutcome(expectedOk, expected, foldedOk, folded)
+				|| !sameOutcome(expectedOk, expected, nativeOk, native)
+				|| !sameOutcome(expectedOk, expected, columnOk, results[row]))
+			{
+				if (failures < 10)
+					std::cout << "FAIL (optimised) \"" << expression << "\" x=" << x[row]
+								<< " y=" << y[row] << std::endl;
+				failures++;
+			}
+		}
+	}
+	return (failures);
+}
+
+static int	infixPrecedence(char op)
+{
+	return ((op == '*' || op == '/') ? 2 : 1);
+}
+
+/*
+	One random tree, written as postfix and as infix. A child gets
+	parentheses only when needed: lower precedence on the left, lower or
+	equal on the right (left associative), plus a few useless ones.
+	`op` is the operator at the root of the written subtree, 0 for a leaf.
+*/
+static void	randomTree(size_t depth, std::string &postfix, std::string &infix, char &op)
+{
+	if (depth == 0 || std::rand() % 4 == 0)
+	{
+		char	leaf = "0123456789xy"[std::rand() % 12];
+		postfix += leaf;
+		postfix += ' ';
+		infix += leaf;
+		op = 0;
+		return ;
+	}
+	op = "+-*/"[std::rand() % 4];
+	std::string	left;
+	std::string	right;
+	char		leftOp = 0;
+	char		rightOp = 0;
+	randomTree(depth - 1, postfix, left, leftOp);
+	randomTree(depth - 1, postfix, right, rightOp);
+	postfix += op;
+	postfix += ' ';
+	if ((leftOp && infixPrecedence(leftOp) < infixPrecedence(op)) || std::rand() % 20 == 0)
+		left = "(" + left + ")";
+	if ((rightOp && infixPrecedence(rightOp) <= infixPrecedence(op)) || std::rand() % 20 == 0)
+		right = "( " + right + " )";
+	infix += left + (std::rand() % 2 ? " " : "") + op + (std::rand() % 2 ? "\t" : "") + right;
+}
+
+static size_t	checkInfixExpressions(size_t rounds)
+{
+	RPN			rpn;
+	RPNInfix	parser;
+	size_t		failures = 0;
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	postfix;
+		std::string	infix;
+		char		op = 0;
+		randomTree(1 + std::rand() % 6, postfix, infix, op);
+		RPNProgram	expected;
+		RPNProgram	program;
+		bool		same = rpn.compile(postfix, expected) && parser.compile(infix, program)
+							&& expected.size() == program.size();
+		for (size_t i = 0; same && i < program.size(); i++)
+			same = (expected[i].opcode == program[i].opcode && expected[i].operand == program[i].operand);
+		if (!same)
+		{
+			if (failures < 10)
+				std::cout << "FAIL (infix) \"" << infix << "\" vs \"" << postfix << "\"" << std::endl;
+			failures++;
+		}
+	}
+	return (failures);
+}
+
+static size_t	checkStreamedExpressions(size_t rounds)
+{
+	RPN		rpn;
+	size_t	failures = 0;
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	expression = randomExpression("0123456789", 10, true, 0);
+		std::string	padded(65536 - 1 - std::rand() % 4, ' ');
+		padded += expression;
+		std::FILE	*file = std::tmpfile();
+		if (file == 0)
+			return (failures + 1);
+		std::fwrite(padded.data(), 1, padded.size(), file);
+		std::fflush(file);
+		lseek(fileno(file), 0, SEEK_SET);
+
+		long	expected = 0;
+		long	streamed = 0;
+		size_t	bytes = 0;
+		bool	expectedOk = rpn.calculateExpression(expression, expected);
+		bool	streamedOk = rpn.calculateStream(fileno(file), streamed, bytes);
+		std::fclose(file);
+		if (!sameOutcome(expectedOk, expected, streamedOk, streamed)
+			|| (streamedOk && bytes != padded.size()))
+		{
+			if (failures < 10)
+				std::cout << "FAIL (stream) \"" << expression << "\"" << std::endl;
+			failures++;
+		}
+	}
+	return (failures);
+}
+
+static long	clampWide(__int128 value)
+{
+	if (value > LONG_MAX)
+		return (LONG_MAX);
+	if (value < LONG_MIN)
+		return (LONG_MIN);
+	return (static_cast<long>(value));
+}
+
+static unsigned long	powerMod(unsigned long base, unsigned long exponent, unsigned long p)
+{
+	unsigned long	result = 1;
+	base %= p;
+	while (exponent > 0)
+	{
+		if (exponent & 1)
+			result = result * base % p;
+		base = base * base % p;
+		exponent >>= 1;
+	}
+	return (result);
+}
+
+// Straightforward semantics of each mode, no shared code with Arithmetic.hpp
+static bool	referenceEvaluate(const RPNProgram &program, const long *variables,
+								RPN::ArithmeticMode mode, long &output)
+{
+	const long			p = 1000000007L;
+	std::vector<long>	stack;
+	for (size_t i = 0; i < program.size(); i++)
+	{
+		long	value = program[i].operand;
+		if (program[i].opcode == RPNProgram::OP_LOAD)
+			value = variables[program[i].operand];
+		if (program[i].opcode == RPNProgram::OP_PUSH || program[i].opcode == RPNProgram::OP_LOAD)
+		{
+			if (mode == RPN::MODE_MODULAR)
+				value = ((value % p) + p) % p;
+			stack.push_back(value);
+			continue;
+		}
+		RPNProgram::OpCode	word = program[i].opcode;
+		if (word == RPNProgram::OP_DUP || word == RPNProgram::OP_DROP)
+		{
+			if (stack.empty())
+				return (false);
+			if (word == RPNProgram::OP_DUP)
+				stack.push_back(stack.back());
+			else
+				stack.pop_back();
+			continue;
+		}
+		if (stack.size() < 2)
+			return (false);
+		if (word == RPNProgram::OP_SWAP)
+		{
+			std::swap(stack[stack.size() - 1], stack[stack.size() - 2]);
+			continue;
+		}
+		if (word == RPNProgram::OP_OVER)
+		{
+			stack.push_back(stack[stack.size() - 2]);
+			continue;
+		}
+		__int128		b = stack.back();
+		stack.pop_back();
+		__int128		a = stack.back();
+		__int128		exact = 0;
+		RPNProgram::OpCode	opcode = program[i].opcode;
+		if (opcode == RPNProgram::OP_DIV && b == 0)
+			return (false);
+		if (mode == RPN::MODE_MODULAR && opcode == RPNProgram::OP_DIV)
+			exact = a * powerMod(static_cast<unsigned long>(b), p - 2, p);
+		else if (opcode == RPNProgram::OP_ADD)
+			exact = a + b;
+		else if (opcode == RPNProgram::OP_SUB)
+			exact = a - b;
+		else if (opcode == RPNProgram::OP_MUL)
+			exact = a * b;
+		else
+			exact = a / b;
+		if (mode == RPN::MODE_CHECKED && clampWide(exact) != exact)
+			return (false);
+		if (mode == RPN::MODE_WRAPPING)
+			stack.back() = static_cast<long>(static_cast<unsigned long>(exact));
+		else if (mode == RPN::MODE_MODULAR)
+			stack.back() = static_cast<long>(((exact % p) + p) % p);
+		else
+			stack.back() = clampWide(exact);
+	}
+	if (stack.size() != 1)
+		return (false);
+	output = stack.back();
+	return (true);
+}
+
+static size_t	checkArithmeticModes(size_t rounds)
+{
+	const RPN::ArithmeticMode	modes[] = {
+		RPN::MODE_CHECKED, RPN::MODE_WRAPPING, RPN::MODE_SATURATING, RPN::MODE_MODULAR
+	};
+	RPN		rpn;
+	size_t	failures = 0;
+	long	variables[26] = {0};
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	expression = randomExpression("0123456789xyxyxy", 16, false, 0);
+		RPNProgram	program;
+		if (rpn.compile(expression, program) == false)
+			continue;
+		for (size_t row = 0; row < 10; row++)
+		{
+			variables['x' - 'a'] = randomValue();
+			variables['y' - 'a'] = randomValue();
+			for (size_t m = 0; m < 4; m++)
+			{
+				long	expected = 0;
+				long	actual = 0;
+				bool	expectedOk = referenceEvaluate(program, variables, modes[m], expected);
+				bool	actualOk = rpn.evaluate(program, variables, actual, modes[m]);
+				if (!sameOutcome(expectedOk, expected, actualOk, actual))
+				{
+					if (failures < 10)
+						std::cout << "FAIL (mode " << m << ") \"" << expression << "\" x="
+									<< variables['x' - 'a'] << " y=" << variables['y' - 'a'] << std::endl;
+					failures++;
+				}
+			}
+		}
+	}
+	return (failures);
+}
+
+/*
+	Left-deep chains whose running value wanders near LONG_MAX / LONG_MIN
+	(the +/- reduction), mixed with * and / and random subtrees.
+*/
+static std::string	randomChain(size_t length)
+{
+	std::string	expression = randomExpression("0123456789xy", 12, false, 0);
+	for (size_t i = 0; i < length; i++)
+	{
+		int	shape = std::rand() % 10;
+		if (shape < 6)
+			expression += "x ";
+		else if (shape < 9)
+			expression += std::string(1, "0123456789y"[std::rand() % 11]) + " ";
+		else
+			expression += randomExpression("0123456789xy", 12, false, 0);
+		expression += (std::rand() % 8 == 0) ? "+-*/"[std::rand() % 4] : "+-"[std::rand() % 2];
+		expression += ' ';
+	}
+	return (expression);
+}
+
+static size_t	checkParallelEvaluation(size_t rounds)
+{
+	RPN			rpn;
+	RPNParallel	parallel(4, 3);
+	size_t		failures = 0;
+	long		variables[26] = {0};
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	expression = (n % 2) ? randomChain(std::rand() % 200)
+									: randomExpression("0123456789xy", 12, false, 40);
+		RPNProgram	program;
+		if (rpn.compile(expression, program) == false)
+			continue;
+		for (size_t row = 0; row < 4; row++)
+		{
+			variables['x' - 'a'] = (row == 0) ? LONG_MAX / 64 : randomValue();
+			variables['y' - 'a'] = randomValue();
+			long	expected = 0;
+			long	actual = 0;
+			bool	expectedOk = rpn.evaluate(program, variables, expected);
+			bool	actualOk = parallel.evaluate(program, variables, actual);
+			if (!sameOutcome(expectedOk, expected, actualOk, actual))
+			{
+				if (failures < 10)
+					std::cout << "FAIL (parallel) \"" << expression.substr(0, 80) << "...\" x="
+								<< variables['x' - 'a'] << " y=" << variables['y' - 'a'] << std::endl;
+				failures++;
+			}
+		}
+	}
+
+	// Right-leaning chains: a one-node spine at every level
+	static const size_t	lengths[] = {100000, 2000000};
+	for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++)
+	{
+		std::string	expression;
+		expression.reserve(lengths[i] * 4);
+		for (size_t n = 0; n < lengths[i]; n++)
+			expression += (n % 3 == 0) ? "x " : "1 ";
+		for (size_t n = 1; n < lengths[i]; n++)
+			expression += (n % 5 == 0) ? "- " : "+ ";
+		RPNProgram	program;
+		RPNParallel	cores(4);
+		long		expected = 0;
+		long		actual = 0;
+		long		tiny = 0;
+		variables['x' - 'a'] = 7;
+		bool		compiled = rpn.compile(expression, program);
+		bool		expectedOk = compiled && rpn.evaluate(program, variables, expected);
+		bool		actualOk = compiled && cores.evaluate(program, variables, actual);
+		bool		tinyOk = compiled && parallel.evaluate(program, variables, tiny);
+		if (!expectedOk || !sameOutcome(expectedOk, expected, actualOk, actual)
+			|| !sameOutcome(expectedOk, expected, tinyOk, tiny))
+		{
+			std::cout << "FAIL (parallel) right-leaning chain of " << lengths[i] << std::endl;
+			failures++;
+		}
+	}
+	return (failures);
+}
+
+static size_t	checkServedExpressions(size_t rounds)
+{
+	RPN							rpn;
+	RPNServer					server(8);
+	std::vector<std::string>	pool;
+	size_t						failures = 0;
+	for (size_t i = 0; i < 40; i++)
+		pool.push_back(randomExpression("0123456789x", 11, true, 0));
+	for (size_t n = 0; n < rounds; n++)
+	{
+		const std::string	&expression = pool[std::rand() % pool.size()];
+		long	expected = 0;
+		long	served = 0;
+		bool	expectedOk = rpn.calculateExpression(expression, expected);
+		bool	servedOk = server.handle(expression, served);
+		if (!sameOutcome(expectedOk, expected, servedOk, served))
+		{
+			if (failures < 10)
+				std::cout << "FAIL (server) \"" << expression << "\"" << std::endl;
+			failures++;
+		}
+	}
+	if (server.requests() != rounds || server.hitRate() <= 0.0)
+	{
+		std::cout << "FAIL (server) " << server.requests() << " requests, hit rate "
+					<< server.hitRate() << std::endl;
+		failures++;
+	}
+	return (failures);
+}
+
+// The byte loop RPNTokenizer::next had before the block masks
+static void	referenceToken(const std::string &text, size_t &pos, RPNTokenizer::Token &token)
+{
+	while (pos < text.size() && RPNTokenizer::isSpace(static_cast<unsigned char>(text[pos])))
+		pos++;
+	token.offset = pos;
+	token.value = 0;
+	token.kind = RPNTokenizer::TOKEN_END;
+	size_t	start = pos;
+	while (pos < text.size() && !RPNTokenizer::isSpace(static_cast<unsigned char>(text[pos])))
+		pos++;
+	token.length = pos - start;
+	if (token.length == 0)
+		return ;
+	char	first = text[start];
+	token.kind = RPNTokenizer::TOKEN_INVALID;
+	if (token.length != 1)
+		return ;
+	if (first >= '0' && first <= '9')
+	{
+		token.kind = RPNTokenizer::TOKEN_NUMBER;
+		token.value = first - '0';
+	}
+	else if (RPNTokenizer::isOperatorChar(first))
+	{
+		token.kind = RPNTokenizer::TOKEN_OPERATOR;
+		token.value = first;
+	}
+	else if (first >= 'a' && first <= 'z')
+	{
+		token.kind = RPNTokenizer::TOKEN_VARIABLE;
+		token.value = first - 'a';
+	}
+}
+
+static size_t	checkTokenizer(size_t rounds)
+{
+	const char	alphabet[] = " \t\n\v\f\r 0123456789+-*/az{`.,\x08\x0e\x1f\x7f\x80\xff";
+	size_t		failures = 0;
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	text;
+		size_t		length = std::rand() % 400;
+		size_t		spaces = 1 + std::rand() % 4; // 1 in `spaces` bytes is a space
+		for (size_t i = 0; i < length; i++)
+		{
+			if (std::rand() % spaces == 0)
+				text += ' ';
+			else
+				text += alphabet[std::rand() % (sizeof(alphabet) - 1)];
+		}
+		RPNTokenizer		tokenizer(text.data(), text.size());
+		RPNTokenizer::Token	actual;
+		RPNTokenizer::Token	expected;
+		size_t				pos = 0;
+		do
+		{
+			tokenizer.next(actual);
+			referenceToken(text, pos, expected);
+			if (actual.kind != expected.kind || actual.value != expected.value
+				|| actual.offset != expected.offset || actual.length != expected.length)
+			{
+				if (failures < 10)
+					std::cout << "FAIL (tokenizer) at offset " << expected.offset
+								<< " of a " << text.size() << " byte input" << std::endl;
+				failures++;
+				break;
+			}
+		}
+		while (expected.kind != RPNTokenizer::TOKEN_END);
+	}
+	return (failures);
+}
+
+/*
+	Mostly well formed: a word is picked among those the stack allows,
+	1 in 50 ignores the depth (underflow), some end with values left.
+*/
+static std::string	randomWords(size_t length)
+{
+	static const char	*words[] = {"dup", "drop", "swap", "over", "+", "-", "*", "/"};
+	std::string	text;
+	size_t		depth = 0;
+	for (size_t i = 0; i < length || depth > 1; i++)
+	{
+		int	pick = std::rand() % 10;
+		if (i >= length && std::rand() % 50 == 0)
+			break;
+		if (i < length && (depth == 0 || pick < 3))
+		{
+			text += "0123456789xyxy"[std::rand() % 14];
+			depth++;
+		}
+		else
+		{
+			size_t	word = std::rand() % 8;
+			if (std::rand() % 50 != 0)
+			{
+				if (depth < 2)
+					word = std::rand() % 2; // dup / drop
+				if (i >= length || (depth == 1 && word == 1))
+					word = 4 + std::rand() % 4;
+			}
+			text += words[word];
+			if (word == 0 || word == 3)
+				depth++;
+			else if (word != 2 && depth > 0)
+				depth--;
+		}
+		text += ' ';
+	}
+	return (text);
+}
+
+static size_t	checkWordPrograms(size_t rounds)
+{
+	const RPN::ArithmeticMode	modes[] = {
+		RPN::MODE_CHECKED, RPN::MODE_WRAPPING, RPN::MODE_SATURATING, RPN::MODE_MODULAR
+	};
+	RPN				rpn;
+	RPNWords		words;
+	RPNOptimizer	optimizer;
+	RPNParallel		parallel(4, 3);
+	size_t			failures = 0;
+	long			x[10];
+	long			y[10];
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	text = randomWords(1 + std::rand() % 30);
+		RPNProgram	program;
+		RPNProgram	optimized;
+		if (words.compile(text, program) == false)
+		{
+			std::cout << "FAIL (words rejected) \"" << text << "\"" << std::endl;
+			failures++;
+			continue;
+		}
+		size_t	maxDepth = 0;
+		bool	wellFormed = program.measureDepth(maxDepth);
+		if (optimizer.optimize(program, optimized) != wellFormed)
+		{
+			std::cout << "FAIL (words optimiser) \"" << text << "\"" << std::endl;
+			failures++;
+			continue;
+		}
+		RPNJit	jit;
+		jit.compile(optimized);
+
+		long			results[10];
+		unsigned char	status[10];
+		const long		*columns[26] = {0};
+		for (size_t row = 0; row < 10; row++)
+		{
+			x[row] = randomValue();
+			y[row] = randomValue();
+		}
+		columns['x' - 'a'] = x;
+		columns['y' - 'a'] = y;
+		bool	columnsOk = rpn.evaluateColumns(program, columns, 10, results, status);
+		for (size_t row = 0; row < 10; row++)
+		{
+			long	variables[26] = {0};
+			variables['x' - 'a'] = x[row];
+			variables['y' - 'a'] = y[row];
+			bool	agree = true;
+			for (size_t m = 0; m < 4; m++)
+			{
+				long	expected = 0;
+				long	actual = 0;
+				bool	expectedOk = referenceEvaluate(program, variables, modes[m], expected);
+				bool	actualOk = rpn.evaluate(program, variables, actual, modes[m]);
+				agree = agree && sameOutcome(expectedOk, expected, actualOk, actual);
+			}
+			long	expected = 0;
+			long	folded = 0;
+			long	native = 0;
+			long	split = 0;
+			bool	expectedOk = referenceEvaluate(program, variables, RPN::MODE_CHECKED, expected);
+			bool	foldedOk = rpn.evaluate(optimized, variables, folded);
+			bool	nativeOk = jit.run(variables, native);
+			bool	splitOk = parallel.evaluate(program, variables, split);
+			bool	columnOk = columnsOk && status[row] == ColumnKernels::ROW_OK;
+			if (!agree
+				|| !sameOutcome(expectedOk, expected, foldedOk, folded)
+				|| !sameOutcome(expectedOk, expected, nativeOk, native)
+				|| !sameOutcome(expectedOk, expected, splitOk, split)
+				|| !sameOutcome(expectedOk, expected, columnOk, results[row]))
+			{
+				if (failures < 10)
+					std::cout << "FAIL (words) \"" << text << "\" x=" << x[row]
+								<< " y=" << y[row] << std::endl;
+				failures++;
+			}
+		}
+	}
+	return (failures);
+}
+
+// ": m BODY ; ... m ... m"  ==  "... BODY ... BODY", instruction by instruction
+static size_t	checkMacroExpansion(size_t rounds)
+{
+	size_t	failures = 0;
+	for (size_t n = 0; n < rounds; n++)
+	{
+		RPNWords	words;
+		std::string	inner = randomWords(1 + std::rand() % 4);
+		std::string	outer = "dup " + std::string(1, "+-*/"[std::rand() % 4]) + " ";
+		std::string	defined = ": inner " + inner + "; : outer_2 inner " + outer + "; ";
+		std::string	expanded;
+		for (size_t i = 0; i < 4; i++)
+		{
+			std::string	operand = randomWords(1 + std::rand() % 3);
+			int			call = std::rand() % 3;
+			defined += operand + (call == 0 ? "inner " : call == 1 ? "outer_2 " : "");
+			expanded += operand + (call == 0 ? inner : call == 1 ? inner + outer : "");
+			if (i > 0)
+			{
+				defined += "+ ";
+				expanded += "+ ";
+			}
+		}
+		RPNProgram	fromMacros;
+		RPNProgram	fromText;
+		bool		macrosOk = words.compile(defined, fromMacros);
+		bool		textOk = words.compile(expanded, fromText);
+		bool		same = macrosOk && textOk && fromMacros.size() == fromText.size()
+							&& words.macroCount() == 2 && words.isDefined("outer_2");
+		for (size_t i = 0; same && i < fromText.size(); i++)
+			same = fromMacros[i].opcode == fromText[i].opcode
+					&& fromMacros[i].operand == fromText[i].operand;
+		if (!same)
+		{
+			if (failures < 10)
+				std::cout << "FAIL (macros) \"" << defined << "\"" << std::endl;
+			failures++;
+		}
+	}
+	const char	*invalid[] = {
+		": x dup ;", ": dup 1 ;", ": 2a 1 ;", ": sq dup *", "1 : sq : q ; ;", "; 1", "1 undefined", ":"
+	};
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+	{
+		RPNWords	words;
+		RPNProgram	program;
+		if (words.compile(invalid[i], program))
+		{
+			std::cout << "FAIL (macros accepted) \"" << invalid[i] << "\"" << std::endl;
+			failures++;
+		}
+	}
+
+	// m1 = 1 instruction, m(k+1) = 2 * mk: past RPN_WORDS_MAX_CODE in a
+	// definition (m40), then in a program calling the last macro that fits
+	std::string	doubling = ": m1 1 ; ";
+	size_t		fits = 1;
+	for (size_t level = 2; level <= 40; level++)
+	{
+		std::ostringstream	definition;
+		definition << ": m" << level << " m" << level - 1 << " m" << level - 1 << " ; ";
+		doubling += definition.str();
+		if ((static_cast<size_t>(1) << (level - 1)) <= RPN_WORDS_MAX_CODE)
+			fits = level;
+	}
+	std::ostringstream	last;
+	last << " m" << fits;
+	RPNWords	words;
+	RPNProgram	program;
+	if (words.compile(doubling, program)
+		|| words.compile(last.str(), program) == false || program.size() != (static_cast<size_t>(1) << (fits - 1))
+		|| words.compile(last.str() + last.str() + " +", program))
+	{
+		std::cout << "FAIL (macros) expansion past " << RPN_WORDS_MAX_CODE << " instructions" << std::endl;
+		failures++;
+	}
+	return (failures);
+}
+
+static size_t	checkIncrementalExpressions(size_t rounds)
+{
+	RPN				rpn;
+	RPNIncremental	incremental;
+	size_t			failures = 0;
+	for (size_t n = 0; n < rounds; n++)
+	{
+		std::string	expression = randomExpression("0123456789", 10, true, (n % 8 == 0) ? 40 : 0);
+		size_t		maxPiece = (n % 3 == 0) ? 1 : 1 + std::rand() % 8;
+		bool		fed = true;
+		for (size_t pos = 0; pos < expression.size(); )
+		{
+			size_t	piece = std::rand() % (maxPiece + 1); // 0: an empty read
+			if (piece > expression.size() - pos)
+				piece = expression.size() - pos;
+			fed = incremental.feed(expression.data() + pos, piece) && fed;
+			pos += piece;
+		}
+		long	expected = 0;
+		long	actual = 0;
+		bool	expectedOk = rpn.calculateExpression(expression, expected);
+		bool	failedEarly = !fed && !incremental.failed();
+		bool	actualOk = incremental.finish(actual);
+		if (!sameOutcome(expectedOk, expected, actualOk, actual) || failedEarly
+			|| (expectedOk && !fed) || incremental.depth() != 0)
+		{
+			if (failures < 10)
+				std::cout << "FAIL (incremental) \"" << expression << "\"" << std::endl;
+			failures++;
+		}
+	}
+	return (failures);
+}
+
+static size_t	checkDeepPrograms()
+{
+	static const size_t	depths[] = {8, 9, 519, 520, 521, 522, 4096, 2000000};
+	RPN		rpn;
+	size_t	failures = 0;
+	for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++)
+	{
+#if defined(__x86_64__)
+		bool		expectNative = depths[i] <= 520;
+#else
+		bool		expectNative = false;
+#endif
+		std::string	expression;
+		expression.reserve(depths[i] * 4);
+		for (size_t n = 0; n < depths[i]; n++)
+			expression += "1 ";
+		for (size_t n = 1; n < depths[i]; n++)
+			expression += "+ ";
+
+		RPNProgram	program;
+		RPNJit		jit;
+		long		native = 0;
+		bool		compiled = rpn.compile(expression, program);
+		bool		isNative = compiled && jit.compile(program);
+		bool		nativeOk = compiled && jit.run(0, native);
+		long		expected = 0;
+		bool		expectedOk = rpn.calculateExpression(expression, expected);
+		if (!sameOutcome(expectedOk, expected, nativeOk, native)
+			|| !expectedOk || isNative != expectNative)
+		{
+			std::cout << "FAIL (deep) depth " << depths[i] << " native " << isNative << std::endl;
+			failures++;
+		}
+	}
+	return (failures);
+}
+
+int	main()
+{
+	std::srand(42);
+	size_t	failures = 0;
+
+	failures += checkDigitExpressions(20000);
+	failures += checkVariablePrograms(5000);
+	failures += checkOptimizedPrograms(5000);
+	failures += checkInfixExpressions(20000);
+	failures += checkStreamedExpressions(500);
+	failures += checkArithmeticModes(5000);
+	failures += checkParallelEvaluation(2000);
+	failures += checkServedExpressions(20000);
+	failures += checkTokenizer(20000);
+	failures += checkWordPrograms(5000);
+	failures += checkMacroExpansion(2000);
+	failures += checkIncrementalExpressions(20000);
+	failures += checkDeepPrograms();
+	if (failures > 0)
+	{
+		std::cout << failures << " mismatch(es)" << std::endl;
+		return (1);
+	}
+	std::cout << "difftest: all evaluation paths agree" << std::endl;
+	return (0);
+}
@@ -0,0 +1,488 @@
+#include "RPN.hpp"
+#include "RPNBatch.hpp"
+#include "RPNJit.hpp"
+#include "RPNServer.hpp"
+#include <algorithm> // std::min
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h> // open
+#include <unistd.h> // fork, execv, dup2
+#include <sys/time.h> // gettimeofday
+#include <sys/wait.h> // waitpid
+
+/*
+	Throughput harness: one generated workload, timed through every
+	evaluation path, written as CSV (one row per mode) to track regressions.
+
+	make throughput && ./RPN_throughput --csv results.csv
+
+	--count N       expressions in the workload                (10000)
+	--length N      tokens per expression, about               (31)
+	--depth N       deepest operand stack allowed, >= 2        (4)
+	--ops CHARS     operator mix, repeat a char to weight it   (+ - * /)
+	--invalid PCT   percentage of broken expressions           (10)
+	--rounds N      passes over the workload, in-process modes (5)
+	--processes N   expressions run by the process baseline    (200)
+	--binary PATH   program for the process baseline           (./RPN)
+	--seed N        same seed, same workload                   (42)
+	--csv FILE      CSV destination                            (stdout)
+
+	Modes:
+	- interpreter : RPN::calculateExpression, the plain ./RPN path
+	- compiled    : RPN::compile + RPN::evaluate for each expression
+	- evaluate    : RPN::evaluate only, programs compiled beforehand
+	- jit         : RPNJit compile + run for each expression
+	- batch       : RPNBatch over all the lines, like ./RPN --batch
+	- server      : RPNServer::handle with a cache as big as the workload,
+	                like ./RPN --server (the first round fills the cache)
+	- process     : fork + exec of ./RPN per expression, like RPN_test.sh
+
+	Every in-process mode must give the results of the interpreter
+	(value or Error) on every expression, otherwise nothing is written.
+
+	Broken expressions are one of, in turn: a bad token, a missing
+	operator (two values left), an extra operator (stack underflow)
+	or a trailing "0 /" (division by zero).
+*/
+
+// =============================================================================
+// Workload
+// =============================================================================
+
+struct	Settings
+{
+	size_t		count;
+	size_t		length;
+	size_t		depth;
+	std::string	operators;
+	size_t		invalidPercent;
+	size_t		rounds;
+	size_t		processes;
+	std::string	binary;
+	unsigned	seed;
+	std::string	csv;
+};
+
+struct	Workload
+{
+	std::vector<std::string>	expressions;
+	size_t						tokens;
+};
+
+/*
+	Operands while the stack may grow, operators when it must shrink:
+	`length` tokens means (length + 1) / 2 operands, the stack never goes
+	deeper than `depth`. depth 2 gives a chain "1 2 + 3 - ...".
+*/
+static std::string	generateValid(const Settings &settings)
+{
+	size_t		operands = (settings.length + 1) / 2;
+	size_t		pushed = 0;
+	size_t		depth = 0;
+	std::string	expression;
+	if (operands == 0)
+		operands = 1;
+	while (pushed < operands || depth > 1)
+	{
+		bool	push = pushed < operands && (depth < 2
+			|| (depth < settings.depth && std::rand() % 2 == 0));
+		if (!expression.empty())
+			expression += ' ';
+		if (push)
+		{
+			expression += static_cast<char>('0' + std::rand() % 10);
+			depth++;
+			pushed++;
+		}
+		else
+		{
+			expression += settings.operators[std::rand() % settings.operators.size()];
+			depth--;
+		}
+	}
+	return (expression);
+}
+
+static std::string	breakExpression(const std::string &expression, size_t kind)
+{
+	if (kind == 0)
+	{
+		std::string	broken = expression;
+		broken[2 * (std::rand() % ((broken.size() + 1) / 2))] = 'a';
+		return (broken);
+	}
+	if (kind == 1)
+		return ("1 " + expression);
+	if (kind == 2)
+		return (expression + " +");
+	return (expression + " 0 /");
+}
+
+// Single-character tokens, one space between them
+static size_t	countTokens(const std::string &expression)
+{
+	return ((expression.size() + 1) / 2);
+}
+
+static void	generateWorkload(const Settings &settings, Workload &workload)
+{
+	std::srand(settings.seed);
+	workload.expressions.clear();
+	workload.tokens = 0;
+	size_t	broken = 0;
+	for (size_t i = 0; i < settings.count; i++)
+	{
+		std::string	expression = generateValid(settings);
+		if (static_cast<size_t>(std::rand() % 100) < settings.invalidPercent)
+			expression = breakExpression(expression, broken++ % 4);
+		workload.expressions.push_back(expression);
+		workload.tokens += countTokens(expression);
+	}
+}
+
+// =============================================================================
+// Modes
+// =============================================================================
+
+struct	Outcome
+{
+	std::vector<char>	success;
+	std::vector<long>	results;
+	double				seconds;
+};
+
+static double	currentTimeSeconds()
+{
+	struct timeval	now;
+	gettimeofday(&now, 0);
+	return (now.tv_sec + now.tv_usec / 1e6);
+}
+
+static void	resetOutcome(Outcome &outcome, size_t count)
+{
+	outcome.success.assign(count, 0);
+	outcome.results.assign(count, 0);
+	outcome.seconds = 0;
+}
+
+static void	runInterpreter(const Workload &workload, size_t rounds, Outcome &outcome)
+{
+	RPN		rpn;
+	size_t	count = workload.expressions.size();
+	resetOutcome(outcome, count);
+	double	start = currentTimeSeconds();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		for (size_t i = 0; i < count; i++)
+			outcome.success[i] = rpn.calculateExpression(workload.expressions[i], outcome.results[i]);
+	}
+	outcome.seconds = currentTimeSeconds() - start;
+}
+
+static void	runCompiled(const Workload &workload, size_t rounds, Outcome &outcome)
+{
+	RPN			rpn;
+	RPNProgram	program;
+	size_t		count = workload.expressions.size();
+	resetOutcome(outcome, count);
+	double	start = currentTimeSeconds();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		for (size_t i = 0; i < count; i++)
+			outcome.success[i] = rpn.compile(workload.expressions[i], program)
+				&& rpn.evaluate(program, outcome.results[i]);
+	}
+	outcome.seconds = currentTimeSeconds() - start;
+}
+
+static void	runEvaluate(const Workload &workload, size_t rounds, Outcome &outcome)
+{
+	RPN						rpn;
+	size_t					count = workload.expressions.size();
+	std::vector<RPNProgram>	programs(count);
+	std::vector<char>		compiled(count);
+	for (size_t i = 0; i < count; i++)
+		compiled[i] = rpn.compile(workload.expressions[i], programs[i]);
+	resetOutcome(outcome, count);
+	double	start = currentTimeSeconds();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		for (size_t i = 0; i < count; i++)
+			outcome.success[i] = compiled[i] && rpn.evaluate(programs[i], outcome.results[i]);
+	}
+	outcome.seconds = currentTimeSeconds() - start;
+}
+
+static void	runJit(const Workload &workload, size_t rounds, Outcome &outcome)
+{
+	RPN			rpn;
+	RPNJit		jit;
+	RPNProgram	program;
+	size_t		count = workload.expressions.size();
+	resetOutcome(outcome, count);
+	double	start = currentTimeSeconds();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (rpn.compile(workload.expressions[i], program) == false)
+			{
+				outcome.success[i] = false;
+				continue;
+			}
+			jit.compile(program);
+			outcome.success[i] = jit.run(0, outcome.results[i]);
+		}
+	}
+	outcome.seconds = currentTimeSeconds() - start;
+}
+
+// The output lines are parsed back after the clock is stopped
+static void	runBatch(const Workload &workload, size_t rounds, Outcome &outcome)
+{
+	size_t				count = workload.expressions.size();
+	std::ostringstream	lines;
+	for (size_t i = 0; i < count; i++)
+		lines << workload.expressions[i] << '\n';
+	std::string	input = lines.str();
+	std::string	output;
+	resetOutcome(outcome, count);
+	double	start = currentTimeSeconds();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		RPNBatch			batch;
+		std::istringstream	in(input);
+		std::ostringstream	out;
+		batch.run(in, out);
+		output = out.str();
+	}
+	outcome.seconds = currentTimeSeconds() - start;
+
+	std::istringstream	results(output);
+	std::string			line;
+	for (size_t i = 0; i < count && std::getline(results, line); i++)
+	{
+		outcome.success[i] = (line != "Error");
+		if (outcome.success[i])
+			outcome.results[i] = std::strtol(line.c_str(), 0, 10);
+	}
+}
+
+static void	runServer(const Workload &workload, size_t rounds, Outcome &outcome)
+{
+	size_t		count = workload.expressions.size();
+	RPNServer	server(count);
+	resetOutcome(outcome, count);
+	double	start = currentTimeSeconds();
+	for (size_t round = 0; round < rounds; round++)
+	{
+		for (size_t i = 0; i < count; i++)
+			outcome.success[i] = server.handle(workload.expressions[i], outcome.results[i]);
+	}
+	outcome.seconds = currentTimeSeconds() - start;
+}
+
+// false if the binary could not be started at all
+static bool	runProcesses(const Workload &workload, const std::string &binary,
+							size_t count, Outcome &outcome)
+{
+	resetOutcome(outcome, count);
+	double	start = currentTimeSeconds();
+	for (size_t i = 0; i < count; i++)
+	{
+		pid_t	pid = fork();
+		if (pid < 0)
+			return (false);
+		if (pid == 0)
+		{
+			int	null = open("/dev/null", O_WRONLY);
+			dup2(null, 1);
+			dup2(null, 2);
+			char	*argv[] = {const_cast<char *>(binary.c_str()),
+				const_cast<char *>(workload.expressions[i].c_str()), 0};
+			execv(binary.c_str(), argv);
+			_exit(127);
+		}
+		int	status = 0;
+		waitpid(pid, &status, 0);
+		if (!WIFEXITED(status) || WEXITSTATUS(status) == 127)
+			return (false);
+		outcome.success[i] = (WEXITSTATUS(status) == 0);
+	}
+	outcome.seconds = currentTimeSeconds() - start;
+	return (true);
+}
+
+// =============================================================================
+// Report
+// =============================================================================
+
+static bool	sameOutcome(const Outcome &reference, const Outcome &outcome, const char *mode)
+{
+	for (size_t i = 0; i < reference.success.size(); i++)
+	{
+		if (reference.success[i] != outcome.success[i]
+			|| (reference.success[i] && reference.results[i] != outcome.results[i]))
+		{
+			std::cerr << "FAIL: " << mode << " differs on expression " << i << std::endl;
+			return (false);
+		}
+	}
+	return (true);
+}
+
+static size_t	countValid(const Outcome &outcome, size_t count)
+{
+	size_t	valid = 0;
+	for (size_t i = 0; i < count; i++)
+		valid += outcome.success[i] ? 1 : 0;
+	return (valid);
+}
+
+static void	writeRow(std::ostream &csv, const Settings &settings, const char *mode,
+						size_t expressions, size_t tokens, size_t valid, double seconds)
+{
+	csv << mode << ',' << settings.count << ',' << settings.length << ',' << settings.depth
+		<< ",\"" << settings.operators << "\"," << settings.invalidPercent << ','
+		<< expressions << ',' << tokens << ',' << valid << ',' << seconds << ',';
+	if (seconds > 0)
+		csv << tokens / seconds << ',' << expressions / seconds;
+	else
+		csv << ',';
+	csv << '\n';
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static bool	parseSize(const char *text, size_t &value)
+{
+	char	*end = 0;
+	long	parsed = std::strtol(text, &end, 10);
+	if (*text == '\0' || *end != '\0' || parsed < 0)
+		return (false);
+	value = static_cast<size_t>(parsed);
+	return (true);
+}
+
+static bool	parseSettings(int ac, char **av, Settings &settings)
+{
+	for (int i = 1; i + 1 < ac; i += 2)
+	{
+		std::string	option = av[i];
+		size_t		value = 0;
+		if (option == "--ops")
+			settings.operators = av[i + 1];
+		else if (option == "--binary")
+			settings.binary = av[i + 1];
+		else if (option == "--csv")
+			settings.csv = av[i + 1];
+		else if (parseSize(av[i + 1], value) == false)
+			return (false);
+		else if (option == "--count")
+			settings.count = value;
+		else if (option == "--length")
+			settings.length = value;
+		else if (option == "--depth")
+			settings.depth = value;
+		else if (option == "--invalid")
+			settings.invalidPercent = value;
+		else if (option == "--rounds")
+			settings.rounds = value;
+		else if (option == "--processes")
+			settings.processes = value;
+		else if (option == "--seed")
+			settings.seed = static_cast<unsigned>(value);
+		else
+			return (false);
+	}
+	if (ac % 2 == 0 || settings.depth < 2 || settings.invalidPercent > 100 || settings.rounds == 0)
+		return (false);
+	if (settings.operators.empty()
+		|| settings.operators.find_first_not_of("+-*/") != std::string::npos)
+		return (false);
+	return (true);
+}
+
+int	main(int ac, char **av)
+{
+	Settings	settings;
+	settings.count = 10000;
+	settings.length = 31;
+	settings.depth = 4;
+	settings.operators = "+-*/";
+	settings.invalidPercent = 10;
+	settings.rounds = 5;
+	settings.processes = 200;
+	settings.binary = "./RPN";
+	settings.seed = 42;
+	if (parseSettings(ac, av, settings) == false)
+	{
+		std::cerr << "Error: see the options at the top of RPN_throughput.cpp" << std::endl;
+		return (1);
+	}
+
+	Workload	workload;
+	generateWorkload(settings, workload);
+	size_t		count = settings.count;
+	size_t		tokens = workload.tokens * settings.rounds;
+
+	Outcome	reference;
+	Outcome	outcome;
+	std::ostringstream	csv;
+	csv << "mode,count,length,depth,ops,invalid_percent,"
+		<< "expressions,tokens,valid,seconds,tokens_per_s,expressions_per_s\n";
+	runInterpreter(workload, settings.rounds, reference);
+	writeRow(csv, settings, "interpreter", count * settings.rounds, tokens,
+		countValid(reference, count), reference.seconds);
+
+	const char	*modes[] = {"compiled", "evaluate", "jit", "batch", "server"};
+	void		(*runners[])(const Workload &, size_t, Outcome &) = {
+		&runCompiled, &runEvaluate, &runJit, &runBatch, &runServer};
+	for (size_t m = 0; m < 5; m++)
+	{
+		runners[m](workload, settings.rounds, outcome);
+		if (sameOutcome(reference, outcome, modes[m]) == false)
+			return (1);
+		writeRow(csv, settings, modes[m], count * settings.rounds, tokens,
+			countValid(outcome, count), outcome.seconds);
+	}
+
+	// Only the success / Error status is visible from outside the process
+	size_t	processes = std::min(settings.processes, count);
+	if (processes > 0)
+	{
+		if (runProcesses(workload, settings.binary, processes, outcome) == false)
+			std::cerr << "process: cannot run " << settings.binary << ", skipped" << std::endl;
+		else
+		{
+			size_t	processTokens = 0;
+			for (size_t i = 0; i < processes; i++)
+			{
+				if (outcome.success[i] != reference.success[i])
+				{
+					std::cerr << "FAIL: process differs on expression " << i << std::endl;
+					return (1);
+				}
+				processTokens += countTokens(workload.expressions[i]);
+			}
+			writeRow(csv, settings, "process", processes, processTokens,
+				countValid(outcome, processes), outcome.seconds);
+		}
+	}
+
+	if (settings.csv.empty())
+	{
+		std::cout << csv.str();
+		return (0);
+	}
+	std::ofstream	file(settings.csv.c_str());
+	if (!(file << csv.str()))
+	{
+		std::cerr << "Error: cannot write " << settings.csv << std::endl;
+		return (1);
+	}
+	return (0);
+}
@@ -1,7 +1,271 @@
 #include "RPN.hpp"
+#include "RPNBatch.hpp"
+#include "RPNInfix.hpp"
+#include "RPNParallel.hpp"
+#include "RPNServer.hpp"
+#include "RPNWords.hpp"
+#include <cstdlib> // strtol
+#include <cerrno> // ERANGE
+#include <fstream>
+#include <iterator> // istreambuf_iterator
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include <sys/time.h> // gettimeofday
+
+/*
+	./RPN "8 9 * 9 - 9 - 9 - 4 - 1 +"
+	./RPN --batch expressions.txt     one expression per line
+	./RPN --batch < expressions.txt   same, from stdin
+	./RPN --big "9 9 * 9 * 9 *"       arbitrary precision, no overflow
+	./RPN --infix "(8 - 2) * 7 + 1"   usual notation, same checks
+	./RPN --words ": sq dup * ; 3 sq 4 sq +"   stack words and macros
+	./RPN --mode wrap "9 9 * ..."     wrap | saturate | mod (1000000007) | checked
+	./RPN --stream huge.rpn           no size limit, GB/s on stderr
+	generator | ./RPN --stream -      same, from stdin
+	./RPN --parallel huge.rpn         one expression, evaluated on every core
+	./RPN_profile --profile exprs.txt one per line, counters on stderr (make profile)
+	client <-> ./RPN --server         one request per line until EOF, cached programs
+	./RPN --server --cache 4096       LRU size (0: no cache, at most 2^24), stats on stderr at EOF
+*/
+static int	runBatch(int ac, char **av)
+{
+	RPNBatch	batch;
+	size_t		errors = 0;
+	if (ac == 2 || std::string(av[2]) == "-")
+		errors = batch.run(std::cin, std::cout);
+	else
+	{
+		std::ifstream	file(av[2]);
+		if (!file)
+		{
+			std::cerr << "Error" << std::endl;
+			return (1);
+		}
+		errors = batch.run(file, std::cout);
+	}
+	if (errors > 0)
+		return (1);
+	return (0);
+}
+
+static double	currentTimeSeconds()
+{
+	struct timeval	now;
+	gettimeofday(&now, 0);
+	return (now.tv_sec + now.tv_usec / 1e6);
+}
+
+static int	runStream(int ac, char **av)
+{
+	int	fd = 0;
+	if (ac == 3 && std::string(av[2]) != "-")
+		fd = open(av[2], O_RDONLY);
+	if (fd < 0)
+	{
+		std::cerr << "Error" << std::endl;
+		return (1);
+	}
+	RPN		rpn;
+	long	results = 0;
+	size_t	bytes = 0;
+	double	start = currentTimeSeconds();
+	bool	success = rpn.calculateStream(fd, results, bytes);
+	double	elapsed = currentTimeSeconds() - start;
+	if (fd != 0)
+		close(fd);
+	if (success == false)
+		std::cerr << "Error" << std::endl;
+	else
+		std::cout << results << std::endl;
+	if (elapsed > 0)
+		std::cerr << bytes << " bytes in " << elapsed << " s: "
+					<< bytes / elapsed / 1e9 << " GB/s" << std::endl;
+	if (success == false)
+		return (1);
+	return (0);
+}
+
+// The whole file is one expression: compiled once, then split across the cores
+static int	runParallel(int ac, char **av)
+{
+	std::string	expression;
+	if (ac == 2 || std::string(av[2]) == "-")
+		expression.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+	else
+	{
+		std::ifstream	file(av[2]);
+		if (!file)
+		{
+			std::cerr << "Error" << std::endl;
+			return (1);
+		}
+		expression.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	RPN			rpn;
+	RPNParallel	parallel;
+	RPNProgram	program;
+	long		results = 0;
+	if (rpn.compile(expression, program) == false)
+	{
+		std::cerr << "Error" << std::endl;
+		return (1);
+	}
+	double	start = currentTimeSeconds();
+	bool	success = parallel.evaluate(program, 0, results);
+	double	elapsed = currentTimeSeconds() - start;
+	if (success == false)
+	{
+		std::cerr << "Error" << std::endl;
+		return (1);
+	}
+	std::cout << results << std::endl;
+	std::cerr << program.size() << " instructions in " << elapsed << " s" << std::endl;
+	return (0);
+}
+
+// Sequential on purpose: one RPN, so one profile for the whole file
+static int	runProfile(int ac, char **av)
+{
+	std::ifstream	file;
+	if (ac == 3 && std::string(av[2]) != "-")
+	{
+		file.open(av[2]);
+		if (!file)
+		{
+			std::cerr << "Error" << std::endl;
+			return (1);
+		}
+	}
+	std::istream	&input = file.is_open() ? static_cast<std::istream &>(file) : std::cin;
+	RPN				rpn;
+	std::string		line;
+	size_t			errors = 0;
+	while (std::getline(input, line))
+	{
+		long	results = 0;
+		if (rpn.calculateExpression(line, results))
+			std::cout << results << '\n';
+		else
+		{
+			std::cout << "Error\n";
+			errors++;
+		}
+	}
+	std::cout << std::flush;
+	if (RPNProfile::enabled())
+		rpn.profile().report(std::cerr);
+	else
+		std::cerr << "profiling is compiled out: make profile, then ./RPN_profile --profile" << std::endl;
+	if (errors > 0)
+		return (1);
+	return (0);
+}
+
+static int	runServer(int ac, char **av)
+{
+	size_t	cacheSize = 1024;
+	if (ac == 4)
+	{
+		char	*end = 0;
+		errno = 0;
+		long	parsed = std::strtol(av[3], &end, 10);
+		if (std::string(av[2]) != "--cache" || *av[3] == '\0' || *end != '\0' || errno == ERANGE
+			|| parsed < 0 || static_cast<unsigned long>(parsed) > RPN_CACHE_MAX)
+		{
+			std::cerr << "Error" << std::endl;
+			return (1);
+		}
+		cacheSize = static_cast<size_t>(parsed);
+	}
+	std::ios::sync_with_stdio(false); // in_avail() then sees what is buffered
+	RPNServer	server(cacheSize);
+	server.run(std::cin, std::cout);
+	server.report(std::cerr);
+	return (0);
+}
+
+static int	runMode(const char *name, const char *expression)
+{
+	RPN					rpn;
+	RPN::ArithmeticMode	mode = RPN::MODE_CHECKED;
+	RPNProgram			program;
+	long				results = 0;
+	if (RPN::parseArithmeticMode(name, mode) == false
+		|| rpn.compile(expression, program) == false
+		|| rpn.evaluate(program, 0, results, mode) == false)
+	{
+		std::cerr << "Error" << std::endl;
+		return (1);
+	}
+	std::cout << results << std::endl;
+	return (0);
+}
+
+static int	runBig(const char *expression)
+{
+	RPN		rpn;
+	BigInt	results;
+	if (rpn.calculateExpressionBig(expression, results) == false)
+	{
+		std::cerr << "Error" << std::endl;
+		return (1);
+	}
+	std::cout << results.toString() << std::endl;
+	return (0);
+}
+
+static int	runInfix(const char *expression)
+{
+	RPNInfix	infix;
+	RPNProgram	program;
+	RPN			rpn;
+	long		results = 0;
+	if (infix.compile(expression, program) == false
+		|| rpn.evaluate(program, results) == false)
+	{
+		std::cerr << "Error" << std::endl;
+		return (1);
+	}
+	std::cout << results << std::endl;
+	return (0);
+}
+
+static int	runWords(const char *expression)
+{
+	RPNWords	words;
+	RPNProgram	program;
+	RPN			rpn;
+	long		results = 0;
+	if (words.compile(expression, program) == false
+		|| rpn.evaluate(program, results) == false)
+	{
+		std::cerr << "Error" << std::endl;
+		return (1);
+	}
+	std::cout << results << std::endl;
+	return (0);
+}
 
 int main(int ac, char **av)
 {
+	if (ac >= 2 && ac <= 3 && std::string(av[1]) == "--batch")
+		return (runBatch(ac, av));
+	if (ac >= 2 && ac <= 3 && std::string(av[1]) == "--stream")
+		return (runStream(ac, av));
+	if ((ac == 2 || ac == 4) && std::string(av[1]) == "--server")
+		return (runServer(ac, av));
+	if (ac >= 2 && ac <= 3 && std::string(av[1]) == "--profile")
+		return (runProfile(ac, av));
+	if (ac >= 2 && ac <= 3 && std::string(av[1]) == "--parallel")
+		return (runParallel(ac, av));
+	if (ac == 4 && std::string(av[1]) == "--mode")
+		return (runMode(av[2], av[3]));
+	if (ac == 3 && std::string(av[1]) == "--big")
+		return (runBig(av[2]));
+	if (ac == 3 && std::string(av[1]) == "--infix")
+		return (runInfix(av[2]));
+	if (ac == 3 && std::string(av[1]) == "--words")
+		return (runWords(av[2]));
 	if (ac != 2)
 	{
 		std::cerr << "Error" << std::endl;
@@ -20,4 +284,4 @@ int main(int ac, char **av)
 		std::cout << results << std::endl;
 		return 0;
 	}
-}
\ No newline at end of file
+}
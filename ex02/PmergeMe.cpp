@@ -86,55 +86,70 @@ size_t	PmergeMe::getNumberSize() const
 // Ford-Johnson (Vector)
 // ==============================================================
 
+void	PmergeMe::fjSortVector(std::vector<unsigned int> &data)
+{
+	std::vector<size_t>	sortedIndices;
+	fjSortVectorInternal(data, sortedIndices);
+	std::vector<unsigned int>	sorted;
+	sorted.reserve(sortedIndices.size());
+	for (size_t i = 0; i < sortedIndices.size(); i++)
+		sorted.push_back(data[sortedIndices[i]]);
+	data.swap(sorted);
+	this->_vec = data;
+}
+
 /*
 	Straggler -> leftover single element
+	Sorts positions instead of values: sortedIndices[i] = where the i-th
+	smallest key is in `keys`. The chains hold positions too, a value is
+	only read to compare it, so the caller knows where every value came from.
+	keys = {30, 10, 20} -> sortedIndices = {1, 2, 0}
 */
-void	PmergeMe::fjSortVector(std::vector<unsigned int> &data)
+void	PmergeMe::fjSortVectorInternal(const std::vector<unsigned int> &keys,
+										std::vector<size_t> &sortedIndices)
 {
 	VectorPair	vectorPair;
 	initialiseVectorPair(vectorPair);
-	makePairsVector(data, vectorPair);
+	makePairsVector(keys, vectorPair);
 	recursiveSortPairsVector(vectorPair.pairs);
 	VectorChain	vectorChain;
-	initialiseVectorChain(vectorChain);
+	initialiseVectorChain(vectorChain, keys.size());
 	buildMainAndPendVector(vectorPair.pairs, vectorChain);
-	// insertStragglerIntoPendVector(vectorPair, vectorChain);
 	buildJacobsthalOrderVector(vectorChain.pend.size(), vectorChain.order);
 	insertPendtoMainChainVector(vectorChain);
-	insertStragglerintoMainChainVector(vectorChain.mainChain, vectorPair);
-	data.assign(vectorChain.mainChain.begin(), vectorChain.mainChain.end());
-	this->_vec = data;
+	insertStragglerintoMainChainVector(keys, vectorChain.mainChain, vectorPair);
+	vectorChain.mainChain.copyTo(sortedIndices);
 }
 
-// Debug Version
-// void PmergeMe::fjSortVector(std::vector<unsigned int> &data)
+// Debug Version: comparisons per phase (top level and every recursion level)
+// void	PmergeMe::fjSortVectorInternal(const std::vector<unsigned int> &keys,
+// 										std::vector<size_t> &sortedIndices)
 // {
-// 	VectorPair vectorPair;
+// 	VectorPair	vectorPair;
 // 	initialiseVectorPair(vectorPair);
 
-// 	size_t beforePairing = _vectorComparisonCount;
-// 	makePairsVector(data, vectorPair);
+// 	size_t	beforePairing = _vectorComparisonCount;
+// 	makePairsVector(keys, vectorPair);
 // 	std::cout << "Pairing: " << (_vectorComparisonCount - beforePairing) << std::endl;
 
-// 	size_t beforeMerge = _vectorComparisonCount;
+// 	size_t	beforeMerge = _vectorComparisonCount;
 // 	recursiveSortPairsVector(vectorPair.pairs);
 // 	std::cout << "Merge: " << (_vectorComparisonCount - beforeMerge) << std::endl;
 
-// 	VectorChain vectorChain;
-// 	initialiseVectorChain(vectorChain);
+// 	VectorChain	vectorChain;
+// 	initialiseVectorChain(vectorChain, keys.size());
 // 	buildMainAndPendVector(vectorPair.pairs, vectorChain);
 // 	buildJacobsthalOrderVector(vectorChain.pend.size(), vectorChain.order);
 
-// 	size_t beforeInsertion = _vectorComparisonCount;
+// 	size_t	beforeInsertion = _vectorComparisonCount;
 // 	insertPendtoMainChainVector(vectorChain);
 // 	std::cout << "Insertion: " << (_vectorComparisonCount - beforeInsertion) << std::endl;
 
-// 	size_t beforeStraggler = _vectorComparisonCount;
-// 	insertStragglerintoMainChainVector(vectorChain.mainChain, vectorPair);
+// 	size_t	beforeStraggler = _vectorComparisonCount;
+// 	insertStragglerintoMainChainVector(keys, vectorChain.mainChain, vectorPair);
 // 	std::cout << "Straggler: " << (_vectorComparisonCount - beforeStraggler) << std::endl;
 
-// 	data.assign(vectorChain.mainChain.begin(), vectorChain.mainChain.end());
-// 	this->_vec = data;
+// 	vectorChain.mainChain.copyTo(sortedIndices);
 // }
 
 void	PmergeMe::initialiseVectorPair(VectorPair &vectorPair)
@@ -152,7 +167,7 @@ void	PmergeMe::makePairsVector(const std::vector<unsigned int> &data,
 	{
 		unsigned int	a = data[i];
 		unsigned int	b = data[i + 1];
-		PairV	newPairs = compareNumberInPairVector(a, b);
+		PairV	newPairs = compareNumberInPairVector(a, b, i);
 		vectorPair.pairs.push_back(newPairs);
 		i += 2;
 	}
@@ -163,7 +178,8 @@ void	PmergeMe::makePairsVector(const std::vector<unsigned int> &data,
 	}
 }
 
-PmergeMe::PairV	PmergeMe::compareNumberInPairVector(const unsigned int &a, const unsigned int &b)
+// a sits at indexOfA, b right after it
+PmergeMe::PairV	PmergeMe::compareNumberInPairVector(const unsigned int &a, const unsigned int &b, size_t indexOfA)
 {
 	this->_vectorComparisonCount++;
 	PairV	temp;
@@ -171,45 +187,72 @@ PmergeMe::PairV	PmergeMe::compareNumberInPairVector(const unsigned int &a, const
 	{
 		temp.small = a;
 		temp.large = b;
+		temp.smallIndex = indexOfA;
+		temp.largeIndex = indexOfA + 1;
 	}
 	else
 	{
 		temp.small = b;
 		temp.large = a;
+		temp.smallIndex = indexOfA + 1;
+		temp.largeIndex = indexOfA;
 	}
 	return (temp);
 }
 
+/*
+	The recursion sorts the large values and returns, for each one, the
+	pair it came from: pairs are reordered in one pass, and equal larges
+	put back in input order in one more, O(n) per level.
+	largeValues = {17, 15, 21} -> sortedIndices = {1, 0, 2}
+*/
 void PmergeMe::recursiveSortPairsVector(std::vector<PairV> &pairs)
 {
 	if (pairs.size() <= 1)
 		return;
 
-	// Extract the 'large' values into a temporary vector
 	std::vector<unsigned int> largeValues;
+	largeValues.reserve(pairs.size());
 	for (size_t i = 0; i < pairs.size(); i++)
 		largeValues.push_back(pairs[i].large);
 
-	// Recursively sort using Ford-Johnson
-	fjSortVector(largeValues);
+	std::vector<size_t>	sortedIndices;
+	fjSortVectorInternal(largeValues, sortedIndices);
+	keepEqualLargesInOrderVector(largeValues, sortedIndices);
 
-	// Rebuild pairs in sorted order by matching large values
 	std::vector<PairV> sortedPairs;
-	for (size_t i = 0; i < largeValues.size(); i++)
+	sortedPairs.reserve(pairs.size());
+	for (size_t i = 0; i < sortedIndices.size(); i++)
+		sortedPairs.push_back(pairs[sortedIndices[i]]);
+	pairs.swap(sortedPairs);
+}
+
+/*
+	Pairs with the same large value keep their input order, as when each
+	sorted value was matched to the first unused pair holding it: the
+	pend (and the comparisons to insert it) stay exactly the same.
+	Bucket pass, no comparison of keys: every index knows the first rank
+	of its run of equal values, then the indices are dealt back in
+	increasing order, each to the next free rank of its run.
+	largeValues = {5, 3, 5, 5}, sortedIndices = {1, 3, 0, 2}
+		runStart = {1, 0, 1, 1} -> sortedIndices = {1, 0, 2, 3}
+*/
+void	PmergeMe::keepEqualLargesInOrderVector(const std::vector<unsigned int> &largeValues,
+												std::vector<size_t> &sortedIndices)
+{
+	std::vector<size_t>	runStart(sortedIndices.size());
+	size_t				start = 0;
+	for (size_t rank = 0; rank < sortedIndices.size(); rank++)
 	{
-		// Find the pair with this large value
-		for (size_t j = 0; j < pairs.size(); j++)
-		{
-			if (pairs[j].large == largeValues[i])
-			{
-				sortedPairs.push_back(pairs[j]);
-				// Mark as used (set to max value to avoid reuse)
-				pairs[j].large = std::numeric_limits<unsigned int>::max();
-				break;
-			}
-		}
+		if (largeValues[sortedIndices[rank]] != largeValues[sortedIndices[start]])
+			start = rank;
+		runStart[sortedIndices[rank]] = start;
 	}
-	pairs = sortedPairs;
+	std::vector<size_t>	nextRank(sortedIndices.size());
+	for (size_t rank = 0; rank < nextRank.size(); rank++)
+		nextRank[rank] = rank;
+	for (size_t index = 0; index < runStart.size(); index++)
+		sortedIndices[nextRank[runStart[index]]++] = index;
 }
 
 
@@ -226,11 +269,10 @@ void PmergeMe::recursiveSortPairsVector(std::vector<PairV> &pairs)
 // 		return (false);
 // }
 
-void	PmergeMe::initialiseVectorChain(VectorChain &vectorChain)
+void	PmergeMe::initialiseVectorChain(VectorChain &vectorChain, size_t valueCount)
 {
-	vectorChain.mainChain.clear();
+	vectorChain.mainChain.reset(valueCount);
 	vectorChain.pend.clear();
-	vectorChain.posOfLarge.clear();
 	vectorChain.order.clear();
 }
 
@@ -241,13 +283,13 @@ void	PmergeMe::buildMainAndPendVector(const std::vector<PairV> &sortedPairs,
 		return;
 
 	// First, insert b₁ (first small) into main chain
-	vectorChain.mainChain.push_back(sortedPairs[0].small);
+	vectorChain.mainChain.pushBack(sortedPairs[0].small, sortedPairs[0].smallIndex);
 
 	// Then insert all large elements, a
 	size_t i = 0;
 	while (i < sortedPairs.size())
 	{
-		vectorChain.mainChain.push_back(sortedPairs[i].large);
+		vectorChain.mainChain.pushBack(sortedPairs[i].large, sortedPairs[i].largeIndex);
 		i++;
 	}
 
@@ -255,39 +297,28 @@ void	PmergeMe::buildMainAndPendVector(const std::vector<PairV> &sortedPairs,
 	i = 1;  // Start from index 1, skip the first pair's small element
 	while (i < sortedPairs.size())
 	{
-		vectorChain.pend.push_back(sortedPairs[i].small);
-		// Position of corresponding large element in main chain
-		// +1 because b₁ is at position 0
-		vectorChain.posOfLarge.push_back(i + 1);
+		// The pair: the main chain gives its large's position when b is
+		// inserted (i + 1 now, b₁ is at position 0)
+		vectorChain.pend.push_back(sortedPairs[i]);
 		i++;
 	}
 }
 
-void	PmergeMe::insertStragglerIntoPendVector(VectorPair &vectorPair, VectorChain &vectorChain)
-{
-	if (vectorPair.hasStraggler)
-	{
-		vectorChain.pend.push_back(vectorPair.straggler);
-		// Straggler's bound is the entire main chain
-		vectorChain.posOfLarge.push_back(vectorChain.mainChain.size());
-	}
-}
-
 /*
 	Inserting Pend value to Main Chain
-	rightBound indicate the position of max value to be compared in Main Chain
+	rightBound indicate the position of max value to be compared in Main Chain:
+	asked to the chain (rankOf) instead of shifting every stored position
+	after each insertion, and the insertion itself only shifts one block
 */
 void	PmergeMe::insertPendtoMainChainVector(VectorChain &vectorChain)
 {
 	size_t	i = 0;
 	while (i < vectorChain.order.size())
 	{
-		size_t	insertIndex = vectorChain.order[i];
-		unsigned int value = vectorChain.pend[insertIndex];
-		size_t	rightBound = vectorChain.posOfLarge[insertIndex];
-		size_t	insertPos = boundedBinarySearchVector(vectorChain.mainChain, value, 0, rightBound);
-		vectorChain.mainChain.insert(vectorChain.mainChain.begin() + static_cast<std::ptrdiff_t>(insertPos), value);
-		increasePosOfLargeVector(vectorChain.posOfLarge, insertPos);
+		const PairV	&pair = vectorChain.pend[vectorChain.order[i]];
+		size_t	rightBound = vectorChain.mainChain.rankOf(pair.large, pair.largeIndex);
+		size_t	insertPos = boundedBinarySearchVector(vectorChain.mainChain, pair.small, rightBound);
+		vectorChain.mainChain.insert(insertPos, pair.small, pair.smallIndex);
 		i++;
 	}
 }
@@ -301,48 +332,28 @@ void	PmergeMe::insertPendtoMainChainVector(VectorChain &vectorChain)
 
 	Imagine it's trying to shrink the window of searching by adjusting left and right bound until
 	left == right
+
+	The window is [0, rightBound) of the main chain, which runs the loop
+	itself (TieredChain::lowerBound) on the keys stored in its blocks
 */
-size_t	PmergeMe::boundedBinarySearchVector(const std::vector<unsigned int> &mainChain,
+size_t	PmergeMe::boundedBinarySearchVector(const TieredChain<std::vector> &mainChain,
 											unsigned int insertValue,
-											size_t leftBound,
 											size_t rightBound)
 {
-	size_t	left = leftBound;
-	size_t	right = rightBound;
-	size_t	insertPos = 0;
-	while (left < right)
-	{
-		size_t	midpoint = left + (right - left) / 2;
-		this->_vectorComparisonCount++;
-		if (insertValue <= mainChain[midpoint])
-			right = midpoint;
-		else
-			left = midpoint + 1;
-	}
-	insertPos = left;
-	return (insertPos);
+	return (mainChain.lowerBound(insertValue, rightBound, this->_vectorComparisonCount));
 }
 
-void	PmergeMe::increasePosOfLargeVector(std::vector<size_t> &posOfLarge, size_t insertPos)
-{
-	size_t	i = 0;
-	while (i < posOfLarge.size())
-	{
-		if (posOfLarge[i] >= insertPos)
-			posOfLarge[i]++;
-		i++;
-	}
-}
-
-void	PmergeMe::insertStragglerintoMainChainVector(std::vector<unsigned int> &mainChain,
+// The straggler is the last key
+void	PmergeMe::insertStragglerintoMainChainVector(const std::vector<unsigned int> &keys,
+													TieredChain<std::vector> &mainChain,
 													VectorPair &vectorPair)
 {
 	bool	hasStraggler = vectorPair.hasStraggler;
 	unsigned int	straggler = vectorPair.straggler;
 	if (hasStraggler == true)
 	{
-		size_t	insertPos = boundedBinarySearchVector(mainChain, straggler, 0, mainChain.size());
-		mainChain.insert(mainChain.begin() + static_cast<std::ptrdiff_t>(insertPos), straggler);
+		size_t	insertPos = boundedBinarySearchVector(mainChain, straggler, mainChain.size());
+		mainChain.insert(insertPos, straggler, keys.size() - 1);
 	}
 }
 
@@ -350,24 +361,35 @@ void	PmergeMe::insertStragglerintoMainChainVector(std::vector<unsigned int> &mai
 // Ford-Johnson (Deque)
 // ==============================================================
 
+void	PmergeMe::fjSortDeque(std::deque<unsigned int> &data)
+{
+	std::deque<size_t>	sortedIndices;
+	fjSortDequeInternal(data, sortedIndices);
+	std::deque<unsigned int>	sorted;
+	for (size_t i = 0; i < sortedIndices.size(); i++)
+		sorted.push_back(data[sortedIndices[i]]);
+	data.swap(sorted);
+	this->_deq = data;
+}
+
 /*
 	Straggler -> leftover single element
+	Sorts positions instead of values (see fjSortVectorInternal)
 */
-void	PmergeMe::fjSortDeque(std::deque<unsigned int> &data)
+void	PmergeMe::fjSortDequeInternal(const std::deque<unsigned int> &keys,
+										std::deque<size_t> &sortedIndices)
 {
 	DequePair	dequePair;
 	initialiseDequePair(dequePair);
-	makePairsDeque(data, dequePair.pairs, dequePair.hasStraggler, dequePair.straggler);
+	makePairsDeque(keys, dequePair.pairs, dequePair.hasStraggler, dequePair.straggler);
 	recursiveSortPairsDeque(dequePair.pairs);
 	DequeChain	dequeChain;
-	initialiseDequeChain(dequeChain);
-	buildMainAndPendDeque(dequePair.pairs, dequeChain.mainChain, dequeChain.pend, dequeChain.posOfLarge);
-	// insertStragglerIntoPendDeque(dequePair , dequeChain);
+	initialiseDequeChain(dequeChain, keys.size());
+	buildMainAndPendDeque(dequePair.pairs, dequeChain.mainChain, dequeChain.pend);
 	buildJacobsthalOrderDeque(dequeChain.pend.size(), dequeChain.order);
 	insertPendtoMainChainDeque(dequeChain);
-	insertStragglerintoMainChainDeque(dequeChain.mainChain, dequePair);
-	data.assign(dequeChain.mainChain.begin(), dequeChain.mainChain.end());
-	this->_deq = data;
+	insertStragglerintoMainChainDeque(keys, dequeChain.mainChain, dequePair);
+	dequeChain.mainChain.copyTo(sortedIndices);
 }
 
 void	PmergeMe::initialiseDequePair(DequePair &dequePair)
@@ -390,7 +412,7 @@ void	PmergeMe::makePairsDeque(const std::deque<unsigned int> &data,
 	{
 		unsigned int	a = data[i];
 		unsigned int	b = data[i + 1];
-		PairD	newPairs = compareNumberInPairDeque(a, b);
+		PairD	newPairs = compareNumberInPairDeque(a, b, i);
 		pairs.push_back(newPairs);
 		i += 2;
 	}
@@ -401,7 +423,8 @@ void	PmergeMe::makePairsDeque(const std::deque<unsigned int> &data,
 	}
 }
 
-PmergeMe::PairD	PmergeMe::compareNumberInPairDeque(const unsigned int &a, const unsigned int &b)
+// a sits at indexOfA, b right after it
+PmergeMe::PairD	PmergeMe::compareNumberInPairDeque(const unsigned int &a, const unsigned int &b, size_t indexOfA)
 {
 	this->_dequeComparisonCount++;
 	PairD	temp;
@@ -409,45 +432,56 @@ PmergeMe::PairD	PmergeMe::compareNumberInPairDeque(const unsigned int &a, const
 	{
 		temp.small = a;
 		temp.large = b;
+		temp.smallIndex = indexOfA;
+		temp.largeIndex = indexOfA + 1;
 	}
 	else
 	{
 		temp.small = b;
 		temp.large = a;
+		temp.smallIndex = indexOfA + 1;
+		temp.largeIndex = indexOfA;
 	}
 	return (temp);
 }
 
+// The recursion returns the pair of each sorted large value: O(n) per level
 void PmergeMe::recursiveSortPairsDeque(std::deque<PairD> &pairs)
 {
 	if (pairs.size() <= 1)
 		return;
 
-	// Extract the 'large' values into a temporary deque
 	std::deque<unsigned int> largeValues;
 	for (size_t i = 0; i < pairs.size(); i++)
 		largeValues.push_back(pairs[i].large);
 
-	// Recursively sort using Ford-Johnson
-	fjSortDeque(largeValues);
+	std::deque<size_t>	sortedIndices;
+	fjSortDequeInternal(largeValues, sortedIndices);
+	keepEqualLargesInOrderDeque(largeValues, sortedIndices);
 
-	// Rebuild pairs in sorted order by matching large values
 	std::deque<PairD> sortedPairs;
-	for (size_t i = 0; i < largeValues.size(); i++)
+	for (size_t i = 0; i < sortedIndices.size(); i++)
+		sortedPairs.push_back(pairs[sortedIndices[i]]);
+	pairs.swap(sortedPairs);
+}
+
+// Equal large values keep their input order (see keepEqualLargesInOrderVector)
+void	PmergeMe::keepEqualLargesInOrderDeque(const std::deque<unsigned int> &largeValues,
+												std::deque<size_t> &sortedIndices)
+{
+	std::deque<size_t>	runStart(sortedIndices.size());
+	size_t				start = 0;
+	for (size_t rank = 0; rank < sortedIndices.size(); rank++)
 	{
-		// Find the pair with this large value
-		for (size_t j = 0; j < pairs.size(); j++)
-		{
-			if (pairs[j].large == largeValues[i])
-			{
-				sortedPairs.push_back(pairs[j]);
-				// Mark as used (set to max value to avoid reuse)
-				pairs[j].large = std::numeric_limits<unsigned int>::max();
-				break;
-			}
-		}
+		if (largeValues[sortedIndices[rank]] != largeValues[sortedIndices[start]])
+			start = rank;
+		runStart[sortedIndices[rank]] = start;
 	}
-	pairs = sortedPairs;
+	std::deque<size_t>	nextRank(sortedIndices.size());
+	for (size_t rank = 0; rank < nextRank.size(); rank++)
+		nextRank[rank] = rank;
+	for (size_t index = 0; index < runStart.size(); index++)
+		sortedIndices[nextRank[runStart[index]]++] = index;
 }
 
 /*
@@ -463,30 +497,28 @@ void PmergeMe::recursiveSortPairsDeque(std::deque<PairD> &pairs)
 // 		return (false);
 // }
 
-void	PmergeMe::initialiseDequeChain(DequeChain &dequeChain)
+void	PmergeMe::initialiseDequeChain(DequeChain &dequeChain, size_t valueCount)
 {
-	dequeChain.mainChain.clear();
+	dequeChain.mainChain.reset(valueCount);
 	dequeChain.pend.clear();
-	dequeChain.posOfLarge.clear();
 	dequeChain.order.clear();
 }
 
 void	PmergeMe::buildMainAndPendDeque(const std::deque<PairD> &sortedPairs,
-										std::deque<unsigned int> &mainChain,
-										std::deque<unsigned int> &pend,
-										std::deque<size_t> &posOfLarge)
+										TieredChain<std::deque> &mainChain,
+										std::deque<PairD> &pend)
 {
 	if (sortedPairs.empty())
 		return;
 
 	// First, insert b₁ (first small) into main chain
-	mainChain.push_back(sortedPairs[0].small);
+	mainChain.pushBack(sortedPairs[0].small, sortedPairs[0].smallIndex);
 
 	// Then insert all large elements
 	size_t i = 0;
 	while (i < sortedPairs.size())
 	{
-		mainChain.push_back(sortedPairs[i].large);
+		mainChain.pushBack(sortedPairs[i].large, sortedPairs[i].largeIndex);
 		i++;
 	}
 
@@ -494,23 +526,12 @@ void	PmergeMe::buildMainAndPendDeque(const std::deque<PairD> &sortedPairs,
 	i = 1;
 	while (i < sortedPairs.size())
 	{
-		pend.push_back(sortedPairs[i].small);
-		// +1 because b₁ is at position 0
-		posOfLarge.push_back(i + 1);
+		// with its large, whose position the main chain gives when b is inserted
+		pend.push_back(sortedPairs[i]);
 		i++;
 	}
 }
 
-void	PmergeMe::insertStragglerIntoPendDeque(DequePair &dequePair, DequeChain &dequeChain)
-{
-	if (dequePair.hasStraggler)
-	{
-		dequeChain.pend.push_back(dequePair.straggler);
-		// Straggler's bound is the entire main chain
-		dequeChain.posOfLarge.push_back(dequeChain.mainChain.size());
-	}
-}
-
 /*
 	Inserting Pend value to Main Chain
 	rightBound indicate the position of max value to be compared in Main Chain
@@ -520,12 +541,10 @@ void	PmergeMe::insertPendtoMainChainDeque(DequeChain &dequeChain)
 	size_t	i = 0;
 	while (i < dequeChain.order.size())
 	{
-		size_t	insertIndex = dequeChain.order[i];
-		unsigned int value = dequeChain.pend[insertIndex];
-		size_t	rightBound = dequeChain.posOfLarge[insertIndex];
-		size_t	insertPos = boundedBinarySearchDeque(dequeChain.mainChain, value, 0, rightBound);
-		dequeChain.mainChain.insert(dequeChain.mainChain.begin() + static_cast<std::ptrdiff_t>(insertPos), value);
-		increasePosOfLargeDeque(dequeChain.posOfLarge, insertPos);
+		const PairD	&pair = dequeChain.pend[dequeChain.order[i]];
+		size_t	rightBound = dequeChain.mainChain.rankOf(pair.large, pair.largeIndex);
+		size_t	insertPos = boundedBinarySearchDeque(dequeChain.mainChain, pair.small, rightBound);
+		dequeChain.mainChain.insert(insertPos, pair.small, pair.smallIndex);
 		i++;
 	}
 }
@@ -539,48 +558,28 @@ void	PmergeMe::insertPendtoMainChainDeque(DequeChain &dequeChain)
 
 	Imagine it's trying to shrink the window of searching by adjusting left and right bound until
 	left == right
+
+	The window is [0, rightBound) of the main chain, which runs the loop
+	itself (TieredChain::lowerBound) on the keys stored in its blocks
 */
-size_t	PmergeMe::boundedBinarySearchDeque(const std::deque<unsigned int> &mainChain,
+size_t	PmergeMe::boundedBinarySearchDeque(const TieredChain<std::deque> &mainChain,
 											unsigned int insertValue,
-											size_t leftBound,
 											size_t rightBound)
 {
-	size_t	left = leftBound;
-	size_t	right = rightBound;
-	size_t	insertPos = 0;
-	while (left < right)
-	{
-		size_t	midpoint = left + (right - left) / 2;
-		this->_dequeComparisonCount++;
-		if (insertValue <= mainChain[midpoint])
-			right = midpoint;
-		else
-			left = midpoint + 1;
-	}
-	insertPos = left;
-	return (insertPos);
-}
-
-void	PmergeMe::increasePosOfLargeDeque(std::deque<size_t> &posOfLarge, size_t insertPos)
-{
-	size_t	i = 0;
-	while (i < posOfLarge.size())
-	{
-		if (posOfLarge[i] >= insertPos)
-			posOfLarge[i]++;
-		i++;
-	}
+	return (mainChain.lowerBound(insertValue, rightBound, this->_dequeComparisonCount));
 }
 
-void	PmergeMe::insertStragglerintoMainChainDeque(std::deque<unsigned int> &mainChain,
+// The straggler is the last key
+void	PmergeMe::insertStragglerintoMainChainDeque(const std::deque<unsigned int> &keys,
+													TieredChain<std::deque> &mainChain,
 													DequePair &dequePair)
 {
 	bool	hasStraggler = dequePair.hasStraggler;
 	unsigned int	straggler = dequePair.straggler;
 	if (hasStraggler == true)
 	{
-		size_t	insertPos = boundedBinarySearchDeque(mainChain, straggler, 0, mainChain.size());
-		mainChain.insert(mainChain.begin() + static_cast<std::ptrdiff_t>(insertPos), straggler);
+		size_t	insertPos = boundedBinarySearchDeque(mainChain, straggler, mainChain.size());
+		mainChain.insert(insertPos, straggler, keys.size() - 1);
 	}
 }
 
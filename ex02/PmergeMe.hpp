@@ -9,6 +9,7 @@
 #include <sstream>
 #include <cstddef>
 #include <cmath> // Required for std::log2 and std::ceil
+#include "TieredChain.hpp"
 
 # ifndef CONVERSION
 #  define CONVERSION 0.000001
@@ -40,6 +41,8 @@ class PmergeMe
 		{
 			unsigned int small;
 			unsigned int large;
+			size_t	smallIndex; // position of each value in the sorted level
+			size_t	largeIndex;
 		};
 
 		struct VectorPair
@@ -49,11 +52,11 @@ class PmergeMe
 			unsigned int		straggler;
 		};
 
+		// mainChain holds (key, index into the level being sorted)
 		struct VectorChain
 		{
-			std::vector<unsigned int>	mainChain;
-			std::vector<unsigned int>	pend;
-			std::vector<size_t>			posOfLarge; // max search when inserting pend to main
+			TieredChain<std::vector>	mainChain;
+			std::vector<PairV>			pend; // small to insert, its large bounds the search
 			std::vector<size_t>			order;
 		};
 
@@ -61,6 +64,8 @@ class PmergeMe
 		{
 			unsigned int small;
 			unsigned int large;
+			size_t	smallIndex; // position of each value in the sorted level
+			size_t	largeIndex;
 		};
 
 		struct DequePair
@@ -70,11 +75,11 @@ class PmergeMe
 			unsigned int	straggler;
 		};
 
+		// mainChain holds (key, index into the level being sorted)
 		struct DequeChain
 		{
-			std::deque<unsigned int>	mainChain;
-			std::deque<unsigned int>	pend;
-			std::deque<size_t>	posOfLarge; // max search when inserting pend to main
+			TieredChain<std::deque>	mainChain;
+			std::deque<PairD>	pend; // small to insert, its large bounds the search
 			std::deque<size_t>	order;
 		};
 
@@ -88,68 +93,69 @@ class PmergeMe
 		// Ford-Johnson (vector)
 
 		void	fjSortVector(std::vector<unsigned int> &data);
-		void	fjSortVectorInternal(std::vector<unsigned int> &data);
+		void	fjSortVectorInternal(const std::vector<unsigned int> &keys,
+									std::vector<size_t> &sortedIndices);
 		void	initialiseVectorPair(VectorPair &vectorPair);
 
 		void	makePairsVector(const std::vector<unsigned int> &data,
 								VectorPair &vectorPair);
-		PairV	compareNumberInPairVector(const unsigned int &a, const unsigned int &b);
+		PairV	compareNumberInPairVector(const unsigned int &a, const unsigned int &b, size_t indexOfA);
 
 		// Recursive Sorting for large
 		void	recursiveSortPairsVector(std::vector<PairV> &pairs);
+		void	keepEqualLargesInOrderVector(const std::vector<unsigned int> &largeValues,
+											std::vector<size_t> &sortedIndices);
 		
-		void	initialiseVectorChain(VectorChain &vectorChain);
+		void	initialiseVectorChain(VectorChain &vectorChain, size_t valueCount);
 		void	buildMainAndPendVector(const std::vector<PairV> &sortedPairs,
 									VectorChain &vectorChain);
-		void	insertStragglerIntoPendVector(VectorPair &vectorPair, VectorChain &vectorChain);
 
 		void	assignInsertOrderVector(size_t numPairs, std::vector<size_t> &JacobsthalNumber, std::vector<size_t> &insertOrder);
 		void	makeJacobsthalNumbersVector(size_t limit, std::vector<size_t> &JacobsthalNumber);
 		void	buildJacobsthalOrderVector(size_t numPairs, std::vector<size_t> &insertOrder);
 		
 		void	insertPendtoMainChainVector(VectorChain &vectorChain);
-		size_t	boundedBinarySearchVector(const std::vector<unsigned int> &mainChain,
+		size_t	boundedBinarySearchVector(const TieredChain<std::vector> &mainChain,
 											unsigned int insertValue,
-											size_t leftBound,
 											size_t rightBound);
-		void	increasePosOfLargeVector(std::vector<size_t> &posOfLarge, size_t insertPos);
 		
-		void	insertStragglerintoMainChainVector(std::vector<unsigned int> &mainChain,
+		void	insertStragglerintoMainChainVector(const std::vector<unsigned int> &keys,
+													TieredChain<std::vector> &mainChain,
 													VectorPair &vectorPair);
 		
 		// Ford-Johnson (Deque)
 		void	fjSortDeque(std::deque<unsigned int> &data);
-		void	fjSortDequeInternal(std::deque<unsigned int> &data);
+		void	fjSortDequeInternal(const std::deque<unsigned int> &keys,
+									std::deque<size_t> &sortedIndices);
 		void	initialiseDequePair(DequePair &dequePair);
 
 		void	makePairsDeque(const std::deque<unsigned int> &data,
 							std::deque<PairD> &pairs,
 							bool &hasStraggler,
 							unsigned int &straggler);
-		PairD	compareNumberInPairDeque(const unsigned int &a, const unsigned int &b);
+		PairD	compareNumberInPairDeque(const unsigned int &a, const unsigned int &b, size_t indexOfA);
 
 		// Recursive call
 		void	recursiveSortPairsDeque(std::deque<PairD> &pairs);
+		void	keepEqualLargesInOrderDeque(const std::deque<unsigned int> &largeValues,
+											std::deque<size_t> &sortedIndices);
 
-		void	initialiseDequeChain(DequeChain &dequeChain);
+		void	initialiseDequeChain(DequeChain &dequeChain, size_t valueCount);
 		void	buildMainAndPendDeque(const std::deque<PairD> &pairs,
-									std::deque<unsigned int> &mainChain,
-									std::deque<unsigned int> &pend,
-									std::deque<size_t> &posOfLarge);
-		void	insertStragglerIntoPendDeque(DequePair &dequePair, DequeChain &dequeChain);
+									TieredChain<std::deque> &mainChain,
+									std::deque<PairD> &pend);
 
 		void	assignInsertOrderDeque(size_t numPairs, std::deque<size_t> &JacobsthalNumber, std::deque<size_t> &insertOrder);
 		void	makeJacobsthalNumbersDeque(size_t limit, std::deque<size_t> &JacobsthalNumber);
 		void	buildJacobsthalOrderDeque(size_t numPairs, std::deque<size_t> &insertOrder);
 
 		void	insertPendtoMainChainDeque(DequeChain &dequeChain);
-		size_t	boundedBinarySearchDeque(const std::deque<unsigned int> &mainChain,
+		size_t	boundedBinarySearchDeque(const TieredChain<std::deque> &mainChain,
 										unsigned int value,
-										size_t leftBound,
 										size_t rightBound);
-		void	increasePosOfLargeDeque(std::deque<size_t> &posOfLarge, size_t insertPos);
 		
-		void	insertStragglerintoMainChainDeque(std::deque<unsigned int> &mainChain,
+		void	insertStragglerintoMainChainDeque(const std::deque<unsigned int> &keys,
+													TieredChain<std::deque> &mainChain,
 													DequePair &dequePair);
 
 	};
@@ -0,0 +1,357 @@
+#ifndef TIEREDCHAIN_HPP
+# define TIEREDCHAIN_HPP
+
+#include <cstddef>
+#include <memory> // std::allocator
+#include <algorithm> // std::lower_bound
+
+# ifndef TIERED_BLOCK
+#  define TIERED_BLOCK 512 // a block splits past 2 * TIERED_BLOCK values
+# endif
+
+# ifndef TIERED_GAP
+#  define TIERED_GAP 8 // positions per block, so that a split finds a free one
+# endif
+
+# define TIERED_NO_BLOCK static_cast<size_t>(-1)
+
+/*
+	Main chain of the Ford-Johnson insertion, as a tiered vector:
+	the sequence is cut into blocks of at most 2 * blockSize values,
+	and a Fenwick tree over the block sizes turns a rank into
+	(block, offset) in O(log blocks).
+
+	Each block keeps the sorted keys next to the values (the indices of
+	the level being sorted, 0 .. valueCount-1, each inserted once):
+	- lowerBound() probes exactly as a binary search over one array (same
+	  midpoints, same comparison count), but reads the keys in the block
+	  itself: the Fenwick tree is only asked while the window still spans
+	  several blocks, then the search stays inside one block
+	- rankOf(key, value) gives a pair's large back where it is now: its
+	  block is known, the key is found by a binary search in it
+	- blocks sit at positions spread out with TIERED_GAP free positions
+	  between them: a split puts the upper half in a free position right
+	  after, one Fenwick update; only when no position is left are the
+	  blocks spread out again (O(positions), rare)
+
+		operation           one std::vector      TieredChain
+		insert(rank)        O(n) shift           O(blockSize) shift + O(log blocks)
+		lowerBound(key)     O(log n)             O(log n) probes, O(log blocks) each
+		                                         until the window is in one block
+		rankOf(key, value)  O(n) update/insert   O(log blockSize + log blocks)
+
+	Measured (-O2, random keys, one core, vector / deque):
+		10^6	2.2 s / 3.8 s	(3.4 s / 6.5 s with at() per probe)
+		10^7	52 s / 103 s	(64 s vector with at() per probe)
+	Short of "10^7 in seconds": the time goes to cache misses, not to
+	work. At 10^7 the insertions of the two top levels take 31 s in
+	lowerBound, 9 s in insert and 4 s in rankOf: until the window is in
+	one block, every probe reads a block (and a Fenwick path) that is not
+	in cache, about 240 ns per miss on the machine measured. Larger
+	blocks trade those misses for longer shifts (TIERED_BLOCK 2048:
+	46 s), no setting tried goes under 45 s.
+
+	Sequence is the container used everywhere inside (std::vector or
+	std::deque), so each PmergeMe path keeps its own container:
+		TieredChain<std::vector>	chain(keys.size());
+*/
+template <template <typename, typename> class Sequence, typename Key = unsigned int>
+class	TieredChain
+{
+	public:
+		typedef Sequence<size_t, std::allocator<size_t> >	Values;
+		typedef Sequence<Key, std::allocator<Key> >			Keys;
+
+		explicit TieredChain(size_t valueCount = 0, size_t blockSize = TIERED_BLOCK):
+			_blockSize(blockSize),
+			_size(0),
+			_blocks(),
+			_blockAt((valueCount / blockSize + 2) * TIERED_GAP, TIERED_NO_BLOCK),
+			_positionOf(),
+			_tree(_blockAt.size() + 1, 0),
+			_blockOf(valueCount, 0),
+			_lastPosition(0)
+		{}
+
+		~TieredChain()
+		{}
+
+		TieredChain(const TieredChain &other):
+			_blockSize(other._blockSize),
+			_size(other._size),
+			_blocks(other._blocks),
+			_blockAt(other._blockAt),
+			_positionOf(other._positionOf),
+			_tree(other._tree),
+			_blockOf(other._blockOf),
+			_lastPosition(other._lastPosition)
+		{}
+
+		TieredChain	&operator=(const TieredChain &other)
+		{
+			if (this != &other)
+			{
+				_blockSize = other._blockSize;
+				_size = other._size;
+				_blocks = other._blocks;
+				_blockAt = other._blockAt;
+				_positionOf = other._positionOf;
+				_tree = other._tree;
+				_blockOf = other._blockOf;
+				_lastPosition = other._lastPosition;
+			}
+			return (*this);
+		}
+
+		// Empty chain for the values 0 .. valueCount-1
+		void	reset(size_t valueCount)
+		{
+			*this = TieredChain(valueCount, _blockSize);
+		}
+
+		size_t	size() const
+		{
+			return (_size);
+		}
+
+		bool	empty() const
+		{
+			return (_size == 0);
+		}
+
+		void	pushBack(const Key &key, size_t value)
+		{
+			insert(_size, key, value);
+		}
+
+		void	insert(size_t rank, const Key &key, size_t value)
+		{
+			if (_blocks.empty())
+				appendBlock();
+			size_t	position = _lastPosition;
+			size_t	offset = _blocks[_blockAt[position]].keys.size();
+			if (rank < _size)
+				position = findPosition(rank, offset);
+			size_t	block = _blockAt[position];
+			Block	&target = _blocks[block];
+			target.keys.insert(target.keys.begin() + static_cast<std::ptrdiff_t>(offset), key);
+			target.values.insert(target.values.begin() + static_cast<std::ptrdiff_t>(offset), value);
+			_blockOf[value] = block;
+			_size++;
+			addToPosition(position, 1);
+			if (target.keys.size() > 2 * _blockSize)
+				split(position);
+		}
+
+		/*
+			First rank in [0, right) whose key is >= key (right if none),
+			one comparison counted per probe
+		*/
+		size_t	lowerBound(const Key &key, size_t right, size_t &comparisons) const
+		{
+			size_t	left = 0;
+			while (left < right)
+			{
+				size_t	midpoint = left + (right - left) / 2;
+				size_t	offset = 0;
+				size_t	position = findPosition(midpoint, offset);
+				const Keys	&keys = _blocks[_blockAt[position]].keys;
+				size_t	start = midpoint - offset;
+				if (left >= start && right <= start + keys.size())
+					return (start + lowerBoundInBlock(keys, key, left - start, right - start, comparisons));
+				comparisons++;
+				if (key <= keys[offset])
+					right = midpoint;
+				else
+					left = midpoint + 1;
+			}
+			return (left);
+		}
+
+		// Where `value` (with this key) is now
+		size_t	rankOf(const Key &key, size_t value) const
+		{
+			size_t			block = _blockOf[value];
+			const Block		&holder = _blocks[block];
+			size_t			offset = static_cast<size_t>(std::lower_bound(holder.keys.begin(),
+										holder.keys.end(), key) - holder.keys.begin());
+			while (holder.values[offset] != value) // equal keys
+				offset++;
+			return (prefix(_positionOf[block]) + offset);
+		}
+
+		template <typename Container>
+		void	copyTo(Container &output) const
+		{
+			output.clear();
+			for (size_t position = 0; position <= _lastPosition && !_blocks.empty(); position++)
+			{
+				if (_blockAt[position] == TIERED_NO_BLOCK)
+					continue;
+				const Values	&values = _blocks[_blockAt[position]].values;
+				output.insert(output.end(), values.begin(), values.end());
+			}
+		}
+
+	private:
+		struct	Block
+		{
+			Keys	keys;
+			Values	values;
+		};
+
+		size_t									_blockSize;
+		size_t									_size;
+		Sequence<Block, std::allocator<Block> >	_blocks;		// by id, never moved
+		Values									_blockAt;		// position -> block id, TIERED_NO_BLOCK = free
+		Values									_positionOf;	// block id -> position
+		Values									_tree;			// Fenwick tree over the sizes, by position
+		Values									_blockOf;		// value -> block id
+		size_t									_lastPosition;
+
+		// Same probes as lowerBound, on the keys of one block
+		static size_t	lowerBoundInBlock(const Keys &keys, const Key &key,
+											size_t left, size_t right, size_t &comparisons)
+		{
+			while (left < right)
+			{
+				size_t	midpoint = left + (right - left) / 2;
+				comparisons++;
+				if (key <= keys[midpoint])
+					right = midpoint;
+				else
+					left = midpoint + 1;
+			}
+			return (left);
+		}
+
+		// The first block, every other one comes from a split
+		void	appendBlock()
+		{
+			_blocks.push_back(Block());
+			_positionOf.push_back(0);
+			_blockAt[0] = 0;
+			_lastPosition = 0;
+		}
+
+		// Sum of the sizes of the blocks before `position`
+		size_t	prefix(size_t position) const
+		{
+			size_t	sum = 0;
+			for (size_t i = position; i > 0; i -= i & (~i + 1))
+				sum += _tree[i];
+			return (sum);
+		}
+
+		void	addToPosition(size_t position, size_t delta)
+		{
+			for (size_t i = position + 1; i < _tree.size(); i += i & (~i + 1))
+				_tree[i] += delta;
+		}
+
+		void	removeFromPosition(size_t position, size_t delta)
+		{
+			for (size_t i = position + 1; i < _tree.size(); i += i & (~i + 1))
+				_tree[i] -= delta;
+		}
+
+		// Block holding `rank` (< size), offset = rank inside it
+		size_t	findPosition(size_t rank, size_t &offset) const
+		{
+			size_t	count = _blockAt.size();
+			size_t	step = 1;
+			while (step * 2 <= count)
+				step *= 2;
+			size_t	position = 0;
+			while (step > 0)
+			{
+				if (position + step <= count && _tree[position + step] <= rank)
+				{
+					position += step;
+					rank -= _tree[position];
+				}
+				step /= 2;
+			}
+			offset = rank;
+			return (position);
+		}
+
+		// First used position after `position` (the end after the last block)
+		size_t	nextPosition(size_t position) const
+		{
+			if (position == _lastPosition)
+				return (_blockAt.size());
+			size_t	next = position + 1;
+			while (_blockAt[next] == TIERED_NO_BLOCK)
+				next++;
+			return (next);
+		}
+
+		// The upper half of a full block becomes a new block right after it
+		void	split(size_t position)
+		{
+			size_t	block = _blockAt[position];
+			size_t	next = nextPosition(position);
+			if (next - position < 2)
+			{
+				spreadOut();
+				position = _positionOf[block];
+				next = nextPosition(position);
+			}
+			size_t	fresh = _blocks.size();
+			_blocks.push_back(Block());
+			Block	&full = _blocks[block];
+			Block	&upper = _blocks[fresh];
+			upper.keys.assign(full.keys.begin() + static_cast<std::ptrdiff_t>(_blockSize), full.keys.end());
+			upper.values.assign(full.values.begin() + static_cast<std::ptrdiff_t>(_blockSize), full.values.end());
+			full.keys.erase(full.keys.begin() + static_cast<std::ptrdiff_t>(_blockSize), full.keys.end());
+			full.values.erase(full.values.begin() + static_cast<std::ptrdiff_t>(_blockSize), full.values.end());
+			for (size_t i = 0; i < upper.values.size(); i++)
+				_blockOf[upper.values[i]] = fresh;
+
+			size_t	freePosition = position + (next - position) / 2;
+			_positionOf.push_back(freePosition);
+			_blockAt[freePosition] = fresh;
+			if (freePosition > _lastPosition)
+				_lastPosition = freePosition;
+			removeFromPosition(position, upper.keys.size());
+			addToPosition(freePosition, upper.keys.size());
+		}
+
+		/*
+			No free position left between two blocks: every block again
+			TIERED_GAP positions or more apart, keeping their order.
+			Every block but the first holds blockSize values or more, so
+			there are at most valueCount / blockSize + 1 of them.
+		*/
+		void	spreadOut()
+		{
+			Values	order;
+			for (size_t position = 0; position <= _lastPosition; position++)
+			{
+				if (_blockAt[position] != TIERED_NO_BLOCK)
+					order.push_back(_blockAt[position]);
+				_blockAt[position] = TIERED_NO_BLOCK;
+			}
+			size_t	spacing = _blockAt.size() / (order.size() + 1);
+			for (size_t i = 0; i < order.size(); i++)
+			{
+				_blockAt[i * spacing] = order[i];
+				_positionOf[order[i]] = i * spacing;
+			}
+			_lastPosition = (order.size() - 1) * spacing;
+
+			size_t	count = _blockAt.size();
+			_tree.assign(count + 1, 0);
+			for (size_t i = 1; i <= count; i++)
+			{
+				if (_blockAt[i - 1] != TIERED_NO_BLOCK)
+					_tree[i] += _blocks[_blockAt[i - 1]].keys.size();
+				size_t	parent = i + (i & (~i + 1));
+				if (parent <= count)
+					_tree[parent] += _tree[i];
+			}
+		}
+};
+
+#endif